@@ -0,0 +1,109 @@
+// ATmega32u4 bench image for bench/avr/simprof.c
+//   Links the keymap sources with the stand-in QMK layer and replays one
+//   scripted key trace through matrix_scan_user()/process_record_user()
+//   for every lighting pattern and OLED state. Each run is announced by a
+//   call to bench_mark(), which simprof watches to split the cycle counts.
+#include "config.h"
+
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+
+#include QMK_KEYBOARD_H
+#include "rgblight.h"
+#include "matrixled.h"
+#include "patterns.h"
+
+#define SCAN_TIME           1   // ms per matrix scan
+#define IDLE_TAIL_TIME      500 // ms of scans after the last key event
+#define KL_CONFIG_MASK      (1ul << 3) // layer_state bit of KL_(CONFIG) in keymap.c
+
+extern rgblight_config_t rgblight_config;
+
+void matrix_init_user(void);
+void matrix_scan_user(void);
+bool process_record_user(uint16_t keycode, keyrecord_t *record);
+
+enum OledState {
+  OS_BASE,          // default layer, status only
+  OS_CONFIG,        // CONFIG layer, status and LED parameters
+  OS_NUM
+};
+
+// scripted key trace, "the quick brown fox" typed on the left half
+static const struct TraceStep {
+  uint8_t dt;       // ms since previous step
+  uint8_t row;
+  uint8_t col;
+  uint8_t pressed;
+} PROGMEM key_trace[] = {
+  {  0, 1, 4, 1 }, { 60, 2, 4, 1 }, { 20, 1, 4, 0 }, { 70, 1, 2, 1 },
+  { 30, 2, 4, 0 }, { 50, 1, 2, 0 }, { 90, 4, 4, 1 }, { 80, 4, 4, 0 },
+  { 40, 1, 0, 1 }, { 70, 1, 0, 0 }, { 30, 1, 3, 1 }, { 60, 1, 3, 0 },
+  { 20, 3, 3, 1 }, { 40, 1, 2, 1 }, { 10, 3, 3, 0 }, { 60, 1, 2, 0 },
+  { 90, 4, 5, 1 }, { 70, 4, 5, 0 }, { 30, 3, 5, 1 }, { 60, 1, 3, 1 },
+  { 10, 3, 5, 0 }, { 50, 1, 3, 0 }, { 40, 1, 1, 1 }, { 70, 1, 1, 0 },
+  { 90, 4, 4, 1 }, { 70, 4, 4, 0 }, { 30, 2, 3, 1 }, { 50, 1, 2, 1 },
+  { 20, 2, 3, 0 }, { 60, 1, 2, 0 }, { 40, 3, 2, 1 }, { 80, 3, 2, 0 },
+};
+#define KEY_TRACE_NUM   (sizeof(key_trace) / sizeof(key_trace[0]))
+
+__attribute__ ((noinline))
+void bench_mark(uint8_t mode, uint8_t oled_state)
+{
+  // simprof reads the arguments from r24/r22 on entry
+  __asm__ volatile ("" :: "r" (mode), "r" (oled_state));
+}
+
+static void scan_until(uint32_t end_time)
+{
+  while (host_timer_ms < end_time) {
+    host_timer_ms += SCAN_TIME;
+    matrix_scan_user();
+  }
+}
+
+static void replay_trace(void)
+{
+  for ( uint8_t idx = 0; idx < KEY_TRACE_NUM; idx++ ) {
+    struct TraceStep step;
+    memcpy_P(&step, &key_trace[idx], sizeof(step));
+
+    scan_until(host_timer_ms + step.dt);
+
+    keyrecord_t record = {
+      .event = {
+        .key = { .row = step.row, .col = step.col },
+        .pressed = step.pressed,
+        .time = timer_read(),
+      },
+    };
+    host_matrix_set(step.row, step.col, step.pressed);
+    process_record_user(KC_A, &record);
+  }
+
+  scan_until(host_timer_ms + IDLE_TAIL_TIME);
+}
+
+int main(void)
+{
+  for ( uint8_t mode = 0; mode < PATTERN_NUM; mode++ ) {
+    for ( uint8_t oled_state = 0; oled_state < OS_NUM; oled_state++ ) {
+      host_reset();
+      eeconfig_update_rgblight_default();
+      rgblight_config.mode = mode;
+      eeconfig_update_rgblight(rgblight_config.raw);
+      layer_state = (oled_state == OS_CONFIG) ? KL_CONFIG_MASK : 0u;
+      matrix_init_user();
+
+      bench_mark(mode, oled_state);
+      replay_trace();
+    }
+  }
+  bench_mark(0xFF, 0xFF);
+
+  // sleeping with interrupts off ends the simulation
+  cli();
+  sleep_enable();
+  sleep_cpu();
+  return 0;
+}
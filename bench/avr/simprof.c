@@ -0,0 +1,218 @@
+// Cycle counter for bench_avr.elf under simavr
+//   Steps the image one instruction at a time and charges the cycles spent
+//   between entry and return of each probed function to the run announced
+//   by the last bench_mark() call. Counts are inclusive of callees and of
+//   any interrupt taken while the function was on the stack.
+//
+//   usage: simprof <image.elf> <image.sym> [function ...]
+//     image.sym is `avr-nm` output for image.elf
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+
+#include <simavr/sim_avr.h>
+#include <simavr/sim_elf.h>
+
+#include "patterns.h"
+
+#define AVR_MCU             "atmega32u4"
+#define AVR_FREQUENCY       16000000u
+#define PROBE_MAX           16
+#define CALL_DEPTH_MAX      32
+#define OLED_STATE_NUM      2
+#define MARK_END            0xFF
+
+static const char * const default_probes[] = {
+  "matrix_scan_user",
+  "matled_refresh_task",
+  "matled_draw",
+  "rgblight_set",
+  "oled_task",
+  "iota_gfx_task_user",
+  "process_record_user",
+};
+
+static const char * const oled_state_names[OLED_STATE_NUM] = {
+  "base", "config",
+};
+
+struct Probe {
+  const char *name;
+  uint32_t addr;
+};
+
+struct Stat {
+  uint32_t calls;
+  uint64_t sum;
+  uint32_t max;
+};
+
+struct Frame {
+  int probe;
+  uint64_t cycle;
+  uint16_t sp;
+};
+
+static struct Probe probes[PROBE_MAX];
+static int probe_num;
+static uint32_t mark_addr;
+
+static struct Stat stats[PATTERN_NUM][OLED_STATE_NUM][PROBE_MAX];
+
+static int load_symbols(const char *sym_file)
+{
+  FILE *fp = fopen(sym_file, "r");
+  if (fp == NULL) {
+    perror(sym_file);
+    return -1;
+  }
+
+  char line[256];
+  while (fgets(line, sizeof(line), fp) != NULL) {
+    unsigned long addr;
+    char type;
+    char name[200];
+    if (sscanf(line, "%lx %c %199s", &addr, &type, name) != 3) {
+      continue;
+    }
+    if (type != 'T' && type != 't') {
+      continue;
+    }
+    if (strcmp(name, "bench_mark") == 0) {
+      mark_addr = addr;
+    }
+    for (int idx = 0; idx < probe_num; idx++) {
+      if (strcmp(name, probes[idx].name) == 0) {
+        probes[idx].addr = addr;
+      }
+    }
+  }
+  fclose(fp);
+
+  if (mark_addr == 0u) {
+    fprintf(stderr, "%s: bench_mark not found\n", sym_file);
+    return -1;
+  }
+  for (int idx = 0; idx < probe_num; idx++) {
+    if (probes[idx].addr == 0u) {
+      fprintf(stderr, "warning: %s not found, inlined?\n", probes[idx].name);
+    }
+  }
+  return 0;
+}
+
+static inline uint16_t read_sp(const avr_t *avr)
+{
+  return avr->data[R_SPL] | (avr->data[R_SPH] << 8);
+}
+
+static int run(avr_t *avr)
+{
+  struct Frame stack[CALL_DEPTH_MAX];
+  int depth = 0;
+  int mode = -1, oled_state = -1;
+
+  for (;;) {
+    uint32_t const pc = avr->pc;
+
+    if (pc == mark_addr) {
+      mode       = avr->data[24];
+      oled_state = avr->data[22];
+      if (mode == MARK_END) {
+        return 0;
+      }
+      if (mode >= PATTERN_NUM || oled_state >= OLED_STATE_NUM) {
+        fprintf(stderr, "bad mark %d/%d\n", mode, oled_state);
+        return -1;
+      }
+    }
+    else if (mode >= 0) {
+      for (int idx = 0; idx < probe_num; idx++) {
+        if (pc == probes[idx].addr && depth < CALL_DEPTH_MAX) {
+          stack[depth++] = (struct Frame){
+            .probe = idx, .cycle = avr->cycle, .sp = read_sp(avr),
+          };
+        }
+      }
+    }
+
+    int const state = avr_run(avr);
+    if (state == cpu_Done || state == cpu_Crashed) {
+      fprintf(stderr, "simulation stopped before the end mark (state %d)\n", state);
+      return -1;
+    }
+
+    // a frame is closed once ret has popped its return address
+    uint16_t const sp = read_sp(avr);
+    while (depth > 0 && sp > stack[depth - 1].sp) {
+      struct Frame *frame = &stack[--depth];
+      struct Stat *stat = &stats[mode][oled_state][frame->probe];
+      uint32_t cycles = avr->cycle - frame->cycle;
+      stat->calls++;
+      stat->sum += cycles;
+      stat->max = (stat->max > cycles) ? stat->max : cycles;
+    }
+  }
+}
+
+static void report(void)
+{
+  printf("# cycles at %u MHz, inclusive of callees and interrupts\n", AVR_FREQUENCY / 1000000u);
+  printf("%-10s %-7s %-22s %8s %10s %10s\n", "pattern", "oled", "function", "calls", "mean", "max");
+  for (int mode = 0; mode < PATTERN_NUM; mode++) {
+    for (int oled_state = 0; oled_state < OLED_STATE_NUM; oled_state++) {
+      for (int idx = 0; idx < probe_num; idx++) {
+        const struct Stat *stat = &stats[mode][oled_state][idx];
+        printf("%-10s %-7s %-22s %8" PRIu32 " %10.1f %10" PRIu32 "\n",
+               pattern_names[mode], oled_state_names[oled_state], probes[idx].name,
+               stat->calls, stat->calls ? (double)stat->sum / stat->calls : 0.,
+               stat->max);
+      }
+    }
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  if (argc < 3) {
+    fprintf(stderr, "usage: %s <image.elf> <image.sym> [function ...]\n", argv[0]);
+    return 2;
+  }
+
+  if (argc > 3) {
+    for (int idx = 3; idx < argc && probe_num < PROBE_MAX; idx++) {
+      probes[probe_num++].name = argv[idx];
+    }
+  }
+  else {
+    for (size_t idx = 0; idx < sizeof(default_probes) / sizeof(default_probes[0]); idx++) {
+      probes[probe_num++].name = default_probes[idx];
+    }
+  }
+  if (load_symbols(argv[2]) < 0) {
+    return 1;
+  }
+
+  elf_firmware_t firmware = { 0 };
+  if (elf_read_firmware(argv[1], &firmware) != 0) {
+    fprintf(stderr, "%s: can't read firmware\n", argv[1]);
+    return 1;
+  }
+
+  avr_t *avr = avr_make_mcu_by_name(AVR_MCU);
+  if (avr == NULL) {
+    fprintf(stderr, "simavr has no %s core\n", AVR_MCU);
+    return 1;
+  }
+  avr_init(avr);
+  avr->frequency = AVR_FREQUENCY;
+  avr_load_firmware(avr, &firmware);
+
+  if (run(avr) < 0) {
+    return 1;
+  }
+  report();
+  return 0;
+}
@@ -0,0 +1,125 @@
+// Host check of the EEPROM write-back cache in eecache.c
+//   Plays key sequences that change the LED mode and the default layer
+//   through process_record_user() and matrix_scan_user() on 1 ms scans,
+//   then reports the bytes eeconfig_update_*() would have written, the
+//   bytes the cache committed, and the ms a scan waited for the EEPROM.
+//   Fails when the EEPROM does not end up with the last settings or a scan
+//   had to wait.
+//
+//   usage: bench_eeprom
+#include "config.h"
+
+#include QMK_KEYBOARD_H
+#include "rgblight.h"
+#include "eeprom.h"
+#include "eecache.h"
+
+#define KEY_INTERVAL        150   // ms between two presses of a sequence
+#define HOLD_TIME           60    // ms
+
+extern rgblight_config_t rgblight_config;
+
+void matrix_init_user(void);
+void matrix_scan_user(void);
+bool process_record_user(uint16_t keycode, keyrecord_t *record);
+void suspend_power_down_user(void);
+
+struct Sequence {
+  const char *name;
+  uint8_t mode_presses;     // RGB_MOD
+  uint8_t layer_changes;    // MO_CONF held while the default layer moves
+  bool is_suspended;        // suspend right after the last key
+};
+
+static const struct Sequence sequences[] = {
+  { "mode x1",        1, 0, false },
+  { "mode x3",        3, 0, false },
+  { "mode full turn", 9, 0, false },
+  { "layer x2",       0, 2, false },
+  { "layer x1",       0, 1, false },
+  { "mode+layer",     4, 3, false },
+  { "mode, suspend",  2, 0, true  },
+};
+
+static void scan(uint32_t ms)
+{
+  for ( uint32_t end = host_timer_ms + ms; host_timer_ms < end; ) {
+    host_timer_ms++;
+    matrix_scan_user();
+  }
+}
+
+static void tap(uint16_t keycode, void (*while_held)(void))
+{
+  keyrecord_t record = { .event = { .key = { .row = 4, .col = 3 }, .pressed = true, .time = timer_read() } };
+  process_record_user(keycode, &record);
+  if (while_held) {
+    while_held();
+  }
+  scan(HOLD_TIME);
+  record.event.pressed = false;
+  record.event.time = timer_read();
+  process_record_user(keycode, &record);
+  scan(KEY_INTERVAL - HOLD_TIME);
+}
+
+// what a DF() key on the CONFIG layer does
+static void default_layer_next(void)
+{
+  default_layer_state = (default_layer_state == 1u) ? 2u : 1u;
+}
+
+static bool play(const struct Sequence *seq)
+{
+  host_reset();
+  eeconfig_update_rgblight_default();
+  rgblight_config.mode = 1;
+  eeconfig_update_rgblight(rgblight_config.raw);
+  eeconfig_update_default_layer(1u);
+  layer_state = 0u;
+  default_layer_state = 1u;
+  matrix_init_user();
+  scan(10);   // the writes above are done
+
+  struct EECacheCounts const begin = *eecache_get_counts();
+  uint32_t const write_begin = host_eeprom_write_count;
+  host_eeprom_wait_ms = 0u;
+
+  for ( uint8_t idx = 0; idx < seq->mode_presses; idx++ ) {
+    tap(RGB_MOD, NULL);
+  }
+  for ( uint8_t idx = 0; idx < seq->layer_changes; idx++ ) {
+    tap(MO(3), default_layer_next);
+  }
+  if (seq->is_suspended) {
+    suspend_power_down_user();
+  }
+  else {
+    scan(EECACHE_QUIET_TIME + 100);
+  }
+
+  const struct EECacheCounts *counts = eecache_get_counts();
+  uint32_t const requested = counts->requested - begin.requested;
+  uint32_t const committed = counts->committed - begin.committed;
+  bool const is_stored = (eeconfig_read_rgblight() == rgblight_config.raw)
+                      && (eeprom_read_byte(EECONFIG_DEFAULT_LAYER) == (uint8_t)default_layer_state);
+  bool const is_pass = is_stored && (host_eeprom_wait_ms == 0u || seq->is_suspended)
+                    && (host_eeprom_write_count - write_begin == committed);
+
+  printf("%-15s %10u %10u %10u %8u %s\n", seq->name, requested, committed,
+         requested - committed, host_eeprom_wait_ms,
+         is_pass ? "ok" : is_stored ? "FAIL waited" : "FAIL not stored");
+  return is_pass;
+}
+
+int main(void)
+{
+  printf("# quiet time %u ms, a byte write takes %u ms\n", EECACHE_QUIET_TIME, EEPROM_WRITE_TIME);
+  printf("%-15s %10s %10s %10s %8s\n", "sequence", "requested", "committed", "avoided", "wait ms");
+
+  bool is_pass = true;
+  for ( size_t idx = 0; idx < sizeof(sequences) / sizeof(sequences[0]); idx++ ) {
+    is_pass &= play(&sequences[idx]);
+  }
+  return is_pass ? 0 : 1;
+}
@@ -0,0 +1,415 @@
+// Key event latency benchmark
+//   Replays typing traces through matrix_scan_user() and process_record_user()
+//   for every lighting pattern, in the order QMK's keyboard_task() runs them:
+//   each 1 ms scan runs matrix_scan_user() first, then the key events the
+//   scan found. Reports per key press
+//     hid: host ns from the start of that scan until process_record_user()
+//          of the key returns, i.e. until the HID report could be sent
+//     led: ms of keyboard time until the next rgblight_set(), for presses
+//          on this half only as DIMLY lights nothing for the other one
+//   and fails when a p99 is over its budget.
+//
+//   usage: bench_latency [-w wpm[,wpm...]] [-k keys] [-s seed] [-f trace]
+//                        [-H hid_budget_ns] [-L led_budget_ms]
+//     -f  replay a recorded trace instead of generated typing, a binary key
+//         trace (keytrace.h) or text with one event per line:
+//         <time ms> <row> <col> <1 press|0 release>, '#' comments
+#include "config.h"
+
+#include <time.h>
+#include <unistd.h>
+
+#include QMK_KEYBOARD_H
+#include "rgblight.h"
+#include "patterns.h"
+#include "keytrace.h"
+
+#define SCAN_TIME           1     // ms
+#define TAIL_TIME           1000  // ms scanned after the last event
+#define WPM_MAX_NUM         8
+#define CHARS_PER_WORD      5     // the WPM convention
+
+extern uint8_t is_master;
+extern rgblight_config_t rgblight_config;
+
+void matrix_init_user(void);
+void matrix_scan_user(void);
+bool process_record_user(uint16_t keycode, keyrecord_t *record);
+
+static struct {
+  uint32_t wpm[WPM_MAX_NUM];
+  int wpm_num;
+  uint32_t keys;
+  unsigned seed;
+  const char *trace_file;
+  uint32_t hid_budget_ns;
+  uint32_t led_budget_ms;
+} options = {
+  .wpm          = { 60, 90, 120, 150 },
+  .wpm_num      = 4,
+  .keys         = 2000u,
+  .seed         = 1u,
+  .hid_budget_ns = 100000u,
+  .led_budget_ms = 2 * 10u,   // two MATLED_TASK_TIME periods
+};
+
+struct KeyEvent {
+  uint32_t time;
+  uint8_t row;
+  uint8_t col;
+  bool pressed;
+};
+
+struct Trace {
+  struct KeyEvent *events;
+  size_t num;
+  size_t cap;
+  uint32_t presses;
+};
+
+struct Samples {
+  uint32_t *values;
+  size_t num;
+  size_t cap;
+};
+
+static inline uint64_t now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static void *grow(void *array, size_t *cap, size_t size)
+{
+  *cap = *cap ? *cap * 2 : 1024;
+  array = realloc(array, *cap * size);
+  if (array == NULL) {
+    perror("realloc");
+    exit(1);
+  }
+  return array;
+}
+
+static void trace_add(struct Trace *trace, struct KeyEvent event)
+{
+  if (trace->num == trace->cap) {
+    trace->events = grow(trace->events, &trace->cap, sizeof(trace->events[0]));
+  }
+  trace->events[trace->num++] = event;
+  trace->presses += event.pressed;
+}
+
+static void samples_add(struct Samples *samples, uint32_t value)
+{
+  if (samples->num == samples->cap) {
+    samples->values = grow(samples->values, &samples->cap, sizeof(samples->values[0]));
+  }
+  samples->values[samples->num++] = value;
+}
+
+static int compare_event(const void *a, const void *b)
+{
+  const struct KeyEvent *x = a, *y = b;
+  if (x->time != y->time) {
+    return (x->time > y->time) - (x->time < y->time);
+  }
+  return x->pressed - y->pressed;   // releases first
+}
+
+static int compare_u32(const void *a, const void *b)
+{
+  uint32_t const x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+  return (x > y) - (x < y);
+}
+
+static uint32_t percentile(const struct Samples *samples, int percent)
+{
+  return samples->num ? samples->values[(samples->num - 1) * percent / 100] : 0u;
+}
+
+static double uniform(double min, double max)
+{
+  return min + (max - min) * rand() / RAND_MAX;
+}
+
+// a key of either half that exists on the Helix rev2 5 row layout
+static void random_key(uint8_t *row, uint8_t *col)
+{
+  do {
+    *row = rand() % HELIX_ROWS;
+    *col = rand() % HELIX_COLS;
+  } while ( (*row < 3) && (*col == HELIX_COLS - 1) );
+  if (rand() & 1) {
+    *row += HELIX_ROWS;
+  }
+}
+
+// Words of 2..8 letters and a space, letters faster than the mean
+// interval and pauses after words, one word in ten as a burst at twice the
+// speed. Holds of 50..130 ms overlap the next press above ~90 WPM.
+static void trace_generate(struct Trace *trace, uint32_t wpm)
+{
+  double const interval = 60000. / (wpm * CHARS_PER_WORD);
+  uint32_t held_until[MATRIX_ROWS][MATRIX_COLS] = { { 0 } };
+  double time = 0.;
+
+  while (trace->presses < options.keys) {
+    int const letters = 2 + rand() % 7;
+    double const speed = (rand() % 10 == 0) ? 2. : 1.;
+    for (int idx = 0; idx <= letters && trace->presses < options.keys; idx++) {
+      bool const is_space = (idx == letters);
+      time += interval * (is_space ? uniform(1.2, 2.2) : uniform(0.4, 1.1)) / speed;
+
+      uint8_t row, col;
+      if (is_space) {
+        row = 4;
+        col = 4;
+      }
+      else {
+        do {
+          random_key(&row, &col);
+        } while (held_until[row][col] >= (uint32_t)time);
+      }
+      uint32_t const press = time;
+      uint32_t const release = press + (uint32_t)uniform(50., 130.);
+      if (held_until[row][col] >= press) {
+        continue;   // the space bar is still down
+      }
+      held_until[row][col] = release;
+
+      trace_add(trace, (struct KeyEvent){ .time = press,   .row = row, .col = col, .pressed = true });
+      trace_add(trace, (struct KeyEvent){ .time = release, .row = row, .col = col, .pressed = false });
+    }
+  }
+  qsort(trace->events, trace->num, sizeof(trace->events[0]), compare_event);
+}
+
+static int trace_load_binary(struct Trace *trace, const char *file, FILE *fp)
+{
+  fseek(fp, 0, SEEK_END);
+  long const size = ftell(fp);
+  rewind(fp);
+  uint8_t *data = malloc(size);
+  if (data == NULL || fread(data, 1, size, fp) != (size_t)size) {
+    perror(file);
+    free(data);
+    return -1;
+  }
+  const char *error = keytrace_header_check((const struct KeyTraceHeader *)data, size);
+  if (error != NULL) {
+    fprintf(stderr, "%s: %s\n", file, error);
+    free(data);
+    return -1;
+  }
+  const uint8_t *it = data + sizeof(struct KeyTraceHeader), *end = data + size;
+  struct KeyTraceEvent event = { 0 };
+  while (keytrace_decode(&it, end, &event)) {
+    trace_add(trace, (struct KeyEvent){
+      .time = event.time, .row = event.row, .col = event.col, .pressed = event.pressed,
+    });
+  }
+  free(data);
+  if (it != end) {
+    fprintf(stderr, "%s: broken record after %zu events\n", file, trace->num);
+    return -1;
+  }
+  return 0;
+}
+
+static int trace_load(struct Trace *trace, const char *file)
+{
+  FILE *fp = fopen(file, "r");
+  if (fp == NULL) {
+    perror(file);
+    return -1;
+  }
+  char magic[sizeof(KEYTRACE_MAGIC) - 1] = { 0 };
+  bool const is_binary = fread(magic, 1, sizeof(magic), fp) == sizeof(magic)
+                      && memcmp(magic, KEYTRACE_MAGIC, sizeof(magic)) == 0;
+  if (is_binary) {
+    int const result = trace_load_binary(trace, file, fp);
+    fclose(fp);
+    return result;
+  }
+  rewind(fp);
+
+  char line[256];
+  int line_num = 0;
+  while (fgets(line, sizeof(line), fp) != NULL) {
+    line_num++;
+    unsigned time, row, col, pressed;
+    if (line[0] == '#' || line[strspn(line, " \t\r\n")] == '\0') {
+      continue;
+    }
+    if (sscanf(line, "%u %u %u %u", &time, &row, &col, &pressed) != 4
+        || row >= MATRIX_ROWS || col >= MATRIX_COLS) {
+      fprintf(stderr, "%s:%d: bad event\n", file, line_num);
+      fclose(fp);
+      return -1;
+    }
+    trace_add(trace, (struct KeyEvent){ .time = time, .row = row, .col = col, .pressed = pressed });
+  }
+  fclose(fp);
+  qsort(trace->events, trace->num, sizeof(trace->events[0]), compare_event);
+  return 0;
+}
+
+// presses waiting for their LED frame
+struct Pending {
+  uint32_t *time;
+  size_t num;
+};
+
+static void led_frame_check(struct Pending *pending, uint32_t *last_set_count, struct Samples *led)
+{
+  if (host_rgblight_set_count == *last_set_count) {
+    return;
+  }
+  *last_set_count = host_rgblight_set_count;
+  for (size_t idx = 0; idx < pending->num; idx++) {
+    samples_add(led, host_timer_ms - pending->time[idx]);
+  }
+  pending->num = 0;
+}
+
+static void bench_trace(int mode, const struct Trace *trace, struct Samples *hid, struct Samples *led)
+{
+  host_reset();
+  eeconfig_update_rgblight_default();
+  rgblight_config.mode = mode;
+  eeconfig_update_rgblight(rgblight_config.raw);
+  layer_state = 0u;
+  default_layer_state = 0u;
+  matrix_init_user();
+  srand(options.seed);
+
+  struct Pending pending = { .time = malloc(trace->num * sizeof(uint32_t)) };
+  uint32_t last_set_count = host_rgblight_set_count;
+  uint32_t const end_time = trace->num ? trace->events[trace->num - 1].time + TAIL_TIME : 0u;
+  size_t next = 0;
+
+  while (host_timer_ms < end_time) {
+    host_timer_ms += SCAN_TIME;
+
+    uint64_t const scan_begin = now_ns();
+    matrix_scan_user();
+    led_frame_check(&pending, &last_set_count, led);
+
+    for ( ; next < trace->num && trace->events[next].time < host_timer_ms; next++) {
+      const struct KeyEvent *event = &trace->events[next];
+      keyrecord_t record = {
+        .event = {
+          .key = { .row = event->row, .col = event->col },
+          .pressed = event->pressed,
+          .time = timer_read(),
+        },
+      };
+      host_matrix_set(event->row, event->col, event->pressed);
+      process_record_user(KC_A, &record);
+      if (event->pressed) {
+        samples_add(hid, now_ns() - scan_begin);
+        if ( (event->row < HELIX_ROWS) == (is_master != 0) ) {
+          pending.time[pending.num++] = host_timer_ms;
+        }
+      }
+      led_frame_check(&pending, &last_set_count, led);
+    }
+  }
+
+  free(pending.time);
+}
+
+static int parse_wpm_list(char *arg)
+{
+  options.wpm_num = 0;
+  for (char *tok = strtok(arg, ","); tok != NULL; tok = strtok(NULL, ",")) {
+    if (options.wpm_num == WPM_MAX_NUM) {
+      return -1;
+    }
+    uint32_t const wpm = strtoul(tok, NULL, 0);
+    if (wpm == 0u || wpm > 1000u) {
+      return -1;
+    }
+    options.wpm[options.wpm_num++] = wpm;
+  }
+  return options.wpm_num ? 0 : -1;
+}
+
+static bool report(const char *trace_name, int mode, struct Samples *hid, struct Samples *led)
+{
+  qsort(hid->values, hid->num, sizeof(hid->values[0]), compare_u32);
+  qsort(led->values, led->num, sizeof(led->values[0]), compare_u32);
+
+  bool const hid_over = percentile(hid, 99) > options.hid_budget_ns;
+  bool const led_over = led->num && percentile(led, 99) > options.led_budget_ms;
+  printf("%-8s %-10s %9u %9u %9u%s", trace_name, pattern_names[mode],
+         percentile(hid, 50), percentile(hid, 99), percentile(hid, 100),
+         hid_over ? "!" : " ");
+  if (led->num) {
+    printf(" %6u %6u %6u%s\n", percentile(led, 50), percentile(led, 99), percentile(led, 100),
+           led_over ? "!" : "");
+  }
+  else {
+    printf(" %6s %6s %6s\n", "-", "-", "-");
+  }
+  return !hid_over && !led_over;
+}
+
+int main(int argc, char *argv[])
+{
+  int opt;
+  while ( (opt = getopt(argc, argv, "w:k:s:f:H:L:")) != -1 ) {
+    switch (opt) {
+      case 'w':
+        if (parse_wpm_list(optarg) < 0) {
+          fprintf(stderr, "-w takes up to %d WPM values of 1..1000\n", WPM_MAX_NUM);
+          return 2;
+        }
+        break;
+      case 'k': options.keys = strtoul(optarg, NULL, 0); break;
+      case 's': options.seed = strtoul(optarg, NULL, 0); break;
+      case 'f': options.trace_file = optarg; break;
+      case 'H': options.hid_budget_ns = strtoul(optarg, NULL, 0); break;
+      case 'L': options.led_budget_ms = strtoul(optarg, NULL, 0); break;
+      default:
+        fprintf(stderr, "usage: %s [-w wpm[,wpm...]] [-k keys] [-s seed] [-f trace]"
+                        " [-H hid_budget_ns] [-L led_budget_ms]\n", argv[0]);
+        return 2;
+    }
+  }
+
+  int const trace_num = options.trace_file ? 1 : options.wpm_num;
+  printf("# p99 budgets: hid %u ns, led %u ms, '!' marks a miss\n",
+         options.hid_budget_ns, options.led_budget_ms);
+  printf("%-8s %-10s %9s %9s %9s  %6s %6s %6s\n", "trace", "pattern",
+         "hid50 ns", "hid99 ns", "hidmax ns", "led50", "led99", "ledmax");
+
+  bool is_pass = true;
+  for (int trace_idx = 0; trace_idx < trace_num; trace_idx++) {
+    struct Trace trace = { 0 };
+    char trace_name[16];
+    srand(options.seed);
+    if (options.trace_file) {
+      if (trace_load(&trace, options.trace_file) < 0) {
+        return 1;
+      }
+      snprintf(trace_name, sizeof(trace_name), "file");
+    }
+    else {
+      trace_generate(&trace, options.wpm[trace_idx]);
+      snprintf(trace_name, sizeof(trace_name), "%uwpm", options.wpm[trace_idx]);
+    }
+
+    for (int mode = 0; mode < PATTERN_NUM; mode++) {
+      struct Samples hid = { 0 }, led = { 0 };
+      bench_trace(mode, &trace, &hid, &led);
+      is_pass &= report(trace_name, mode, &hid, &led);
+      free(hid.values);
+      free(led.values);
+    }
+    free(trace.events);
+  }
+
+  return is_pass ? 0 : 1;
+}
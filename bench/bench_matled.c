@@ -0,0 +1,152 @@
+// Host benchmark for the lighting engine in matrixled.c
+//   Runs every LightingPattern against the same synthetic typing load and
+//   reports the host time spent per matled_refresh_task() and per
+//   matled_record_event() call, and the RIPPLE and CROSS sources in flight.
+//
+//   usage: bench_matled [-n frames] [-r keys_per_sec] [-s seed] [-S]
+//     -S  run as the slave half (is_master = 0)
+#include "config.h"
+
+#include <time.h>
+#include <unistd.h>
+
+#include QMK_KEYBOARD_H
+#include "rgblight.h"
+#include "matrixled.h"
+#include "patterns.h"
+
+#define FRAME_TIME          10  // ms, same as MATLED_TASK_TIME
+#define HOLD_TIME           80  // ms
+
+extern uint8_t is_master;
+extern rgblight_config_t rgblight_config;
+
+static struct {
+  uint32_t frames;
+  uint32_t keys_per_sec;
+  unsigned seed;
+} options = {
+  .frames       = 100000u,
+  .keys_per_sec = 8u,
+  .seed         = 1u,
+};
+
+struct Measure {
+  uint64_t ns;
+  uint32_t count;
+};
+
+static inline uint64_t now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static keypos_t random_keypos(void)
+{
+  keypos_t key;
+  do {
+    key.row = rand() % HELIX_ROWS;
+    key.col = rand() % HELIX_COLS;
+  } while ( (key.row < 3) && (key.col == HELIX_COLS - 1) );
+
+  if (!is_master) {
+    key.row += HELIX_ROWS;
+  }
+  return key;
+}
+
+static void key_event(keypos_t key, bool pressed, struct Measure *event)
+{
+  keyrecord_t record = {
+    .event = { .key = key, .pressed = pressed, .time = timer_read() },
+  };
+  host_matrix_set(key.row, key.col, pressed);
+
+  uint64_t begin = now_ns();
+  matled_record_event(KC_A, &record);
+  event->ns += now_ns() - begin;
+  event->count++;
+}
+
+static void bench_pattern(int mode, struct Measure *refresh, struct Measure *event, uint32_t *idle_time)
+{
+  host_reset();
+  eeconfig_update_rgblight_default();
+  rgblight_config.mode = mode;
+  eeconfig_update_rgblight(rgblight_config.raw);
+  matled_init();
+  host_rgblight_set_count = 0u;
+  srand(options.seed);
+
+  uint32_t const key_interval = 1000u / options.keys_per_sec;
+  uint32_t next_press = key_interval;
+  uint32_t release_at = 0u;
+  keypos_t held = { 0 };
+  bool is_holding = false;
+  uint32_t const idle_begin = matled_get_idle_time();
+
+  for ( uint32_t frame = 0; frame < options.frames; frame++ ) {
+    host_timer_ms += FRAME_TIME;
+
+    if ( is_holding && (host_timer_ms >= release_at) ) {
+      key_event(held, false, event);
+      is_holding = false;
+    }
+    if ( !is_holding && (host_timer_ms >= next_press) ) {
+      held = random_keypos();
+      key_event(held, true, event);
+      is_holding = true;
+      release_at = host_timer_ms + HOLD_TIME;
+      next_press += key_interval;
+    }
+
+    uint64_t begin = now_ns();
+    matled_refresh_task();
+    refresh->ns += now_ns() - begin;
+    refresh->count++;
+  }
+
+  *idle_time = matled_get_idle_time() - idle_begin;
+}
+
+int main(int argc, char *argv[])
+{
+  int opt;
+  while ( (opt = getopt(argc, argv, "n:r:s:S")) != -1 ) {
+    switch (opt) {
+      case 'n': options.frames = strtoul(optarg, NULL, 0); break;
+      case 'r': options.keys_per_sec = strtoul(optarg, NULL, 0); break;
+      case 's': options.seed = strtoul(optarg, NULL, 0); break;
+      case 'S': is_master = 0; break;
+      default:
+        fprintf(stderr, "usage: %s [-n frames] [-r keys_per_sec] [-s seed] [-S]\n", argv[0]);
+        return 2;
+    }
+  }
+  if ( options.keys_per_sec == 0u || options.keys_per_sec > 1000u / FRAME_TIME ) {
+    fprintf(stderr, "keys_per_sec must be 1..%d\n", 1000 / FRAME_TIME);
+    return 2;
+  }
+
+  printf("# frames=%u keys_per_sec=%u seed=%u half=%s\n",
+         options.frames, options.keys_per_sec, options.seed, is_master ? "master" : "slave");
+  printf("%-10s %12s %12s %10s %6s %5s %8s %8s\n", "pattern", "ns/refresh", "ns/event", "led_sets", "idle%",
+         "peak", "evicted", "merged");
+
+  for ( int mode = 0; mode < PATTERN_NUM; mode++ ) {
+    struct Measure refresh = { 0 }, event = { 0 };
+    uint32_t idle_time;
+    bench_pattern(mode, &refresh, &event, &idle_time);
+    const struct MatledPressedCounts *pressed = matled_get_pressed_counts();
+    printf("%-10s %12.1f %12.1f %10u %6.1f %5u %8u %8u\n", pattern_names[mode],
+           refresh.count ? (double)refresh.ns / refresh.count : 0.,
+           event.count   ? (double)event.ns / event.count : 0.,
+           host_rgblight_set_count,
+           100. * idle_time / host_timer_ms,
+           pressed->peak, pressed->evicted, pressed->coalesced);
+  }
+
+  return 0;
+}
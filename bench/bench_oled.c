@@ -0,0 +1,92 @@
+// Host benchmark for the OLED status in keymap.c
+//   Times iota_gfx_task_user() with steady inputs and with an input that
+//   changes every call, on the base and the CONFIG layer, and counts the
+//   I2C bytes oled_task() sends for those changes.
+//
+//   usage: bench_oled [-n calls]
+#include "config.h"
+
+#include <time.h>
+#include <unistd.h>
+
+#include QMK_KEYBOARD_H
+#include "rgblight.h"
+#include "ssd1306.h"
+
+#define KL_CONFIG_MASK      (1ul << 3) // layer_state bit of KL_(CONFIG) in keymap.c
+#define SETTLE_SCANS        100
+
+extern rgblight_config_t rgblight_config;
+
+void matrix_init_user(void);
+void matrix_scan_user(void);
+
+static struct {
+  uint32_t calls;
+} options = {
+  .calls = 100000u,
+};
+
+static inline uint64_t now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static void bench_render(const char *name, uint32_t layer, bool is_changing)
+{
+  host_reset();
+  eeconfig_update_rgblight_default();
+  layer_state = layer;
+  matrix_init_user();
+
+  // settle the first render and flush
+  for ( int scan = 0; scan < SETTLE_SCANS; scan++ ) {
+    host_timer_ms++;
+    matrix_scan_user();
+  }
+
+  uint64_t begin = now_ns();
+  for ( uint32_t call = 0; call < options.calls; call++ ) {
+    if (is_changing) {
+      rgblight_config.hue = (rgblight_config.hue + 1) % 360;
+    }
+    iota_gfx_task_user();
+  }
+  uint64_t const ns = now_ns() - begin;
+
+  // bus cost of one more change, a sliced flush is done well within SETTLE_SCANS
+  host_i2c_byte_count = 0u;
+  if (is_changing) {
+    rgblight_config.hue = (rgblight_config.hue + 1) % 360;
+  }
+  for ( int scan = 0; scan < SETTLE_SCANS; scan++ ) {
+    host_timer_ms++;
+    matrix_scan_user();
+  }
+
+  printf("%-16s %12.1f %10u\n", name, (double)ns / options.calls, host_i2c_byte_count);
+}
+
+int main(int argc, char *argv[])
+{
+  int opt;
+  while ( (opt = getopt(argc, argv, "n:")) != -1 ) {
+    switch (opt) {
+      case 'n': options.calls = strtoul(optarg, NULL, 0); break;
+      default:
+        fprintf(stderr, "usage: %s [-n calls]\n", argv[0]);
+        return 2;
+    }
+  }
+
+  printf("# calls=%u\n", options.calls);
+  printf("%-16s %12s %10s\n", "case", "ns/call", "i2c_bytes");
+  bench_render("base/steady",   0u,             false);
+  bench_render("base/hue",      0u,             true);
+  bench_render("config/steady", KL_CONFIG_MASK, false);
+  bench_render("config/hue",    KL_CONFIG_MASK, true);
+
+  return 0;
+}
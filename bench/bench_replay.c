@@ -0,0 +1,248 @@
+// Replay of a recorded key trace through the keymap
+//   Maps a binary key trace (keytrace.h, from trace_decode -k) and feeds
+//   its events to process_record_user() and matled_refresh_task() on 1 ms
+//   scans of synthetic time, paced to a multiple of real time. Reports per
+//   lighting pattern the replay speed, the host time per scan and per key
+//   event without the pacing sleeps, the LED frames sent, and the RIPPLE
+//   and CROSS sources in flight.
+//
+//   usage: bench_replay [-x speed] [-m mode[,mode...]] [-S] keytrace
+//     -x  times real time to replay at, 0 for as fast as possible
+//     -m  patterns to replay, all by default
+//     -S  run as the slave half (is_master = 0)
+#include "config.h"
+
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include QMK_KEYBOARD_H
+#include "rgblight.h"
+#include "matrixled.h"
+#include "patterns.h"
+#include "keytrace.h"
+
+#define SCAN_TIME           1     // ms
+#define PACE_INTERVAL       1000  // scans between two pacing checks
+
+extern uint8_t is_master;
+extern rgblight_config_t rgblight_config;
+
+void matrix_init_user(void);
+bool process_record_user(uint16_t keycode, keyrecord_t *record);
+
+static struct {
+  uint32_t speed;
+  bool modes[PATTERN_NUM];
+} options = {
+  .speed = 1000u,
+};
+
+struct Replay {
+  const uint8_t *begin;
+  const uint8_t *end;
+  uint32_t event_num;
+  uint32_t duration;
+};
+
+struct Result {
+  uint64_t host_ns;
+  uint64_t sleep_ns;
+  uint64_t event_ns;
+  uint32_t events;
+  uint32_t scans;
+  bool is_broken;
+};
+
+static inline uint64_t now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static int replay_map(struct Replay *replay, const char *file)
+{
+  int fd = open(file, O_RDONLY);
+  if (fd < 0) {
+    perror(file);
+    return -1;
+  }
+  struct stat st;
+  if (fstat(fd, &st) < 0 || st.st_size == 0) {
+    fprintf(stderr, "%s: empty or unreadable\n", file);
+    close(fd);
+    return -1;
+  }
+  void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    perror("mmap");
+    return -1;
+  }
+  madvise(map, st.st_size, MADV_SEQUENTIAL);
+
+  const struct KeyTraceHeader *header = map;
+  const char *error = keytrace_header_check(header, st.st_size);
+  if (error != NULL) {
+    fprintf(stderr, "%s: %s\n", file, error);
+    munmap(map, st.st_size);
+    return -1;
+  }
+  replay->begin     = (const uint8_t *)map + sizeof(*header);
+  replay->end       = (const uint8_t *)map + st.st_size;
+  replay->event_num = header->event_num;
+  replay->duration  = header->duration;
+  return 0;
+}
+
+// sleeps while the replay is ahead of speed times real time,
+// returns the ns slept
+static uint64_t pace(uint64_t host_begin)
+{
+  if (options.speed == 0u) {
+    return 0u;
+  }
+  uint64_t const due = host_begin + (uint64_t)host_timer_ms * 1000000u / options.speed;
+  uint64_t const now = now_ns();
+  if (due <= now) {
+    return 0u;
+  }
+  struct timespec ts = { .tv_sec = (due - now) / 1000000000u, .tv_nsec = (due - now) % 1000000000u };
+  nanosleep(&ts, NULL);
+  return now_ns() - now;
+}
+
+static void replay_pattern(int mode, const struct Replay *replay, struct Result *result)
+{
+  host_reset();
+  eeconfig_update_rgblight_default();
+  rgblight_config.mode = mode;
+  eeconfig_update_rgblight(rgblight_config.raw);
+  layer_state = 0u;
+  default_layer_state = 0u;
+  matrix_init_user();
+  host_rgblight_set_count = 0u;
+
+  const uint8_t *it = replay->begin;
+  struct KeyTraceEvent event = { 0 };
+  bool is_pending = keytrace_decode(&it, replay->end, &event);
+  uint64_t const host_begin = now_ns();
+
+  while (is_pending) {
+    host_timer_ms += SCAN_TIME;
+
+    if (is_pending && event.time < host_timer_ms) {
+      uint64_t const event_begin = now_ns();
+      do {
+        keyrecord_t record = {
+          .event = {
+            .key = { .row = event.row, .col = event.col },
+            .pressed = event.pressed,
+            .time = timer_read(),
+          },
+        };
+        host_matrix_set(event.row, event.col, event.pressed);
+        process_record_user(KC_A, &record);
+        result->events++;
+        is_pending = keytrace_decode(&it, replay->end, &event);
+      } while (is_pending && event.time < host_timer_ms);
+      result->event_ns += now_ns() - event_begin;
+    }
+
+    matled_refresh_task();
+    result->scans++;
+
+    if (result->scans % PACE_INTERVAL == 0u) {
+      result->sleep_ns += pace(host_begin);
+    }
+  }
+
+  result->host_ns = now_ns() - host_begin;
+  result->is_broken = (it != replay->end);
+}
+
+static int parse_mode_list(char *arg)
+{
+  for (char *tok = strtok(arg, ","); tok != NULL; tok = strtok(NULL, ",")) {
+    int mode = -1;
+    for (int idx = 0; idx < PATTERN_NUM; idx++) {
+      if (strcmp(tok, pattern_names[idx]) == 0) {
+        mode = idx;
+      }
+    }
+    if (mode < 0) {
+      char *end;
+      unsigned long const num = strtoul(tok, &end, 0);
+      if (*end != '\0' || num >= PATTERN_NUM) {
+        return -1;
+      }
+      mode = num;
+    }
+    options.modes[mode] = true;
+  }
+  return 0;
+}
+
+int main(int argc, char *argv[])
+{
+  bool is_mode_given = false;
+  int opt;
+  while ( (opt = getopt(argc, argv, "x:m:S")) != -1 ) {
+    switch (opt) {
+      case 'x': options.speed = strtoul(optarg, NULL, 0); break;
+      case 'm':
+        if (parse_mode_list(optarg) < 0) {
+          fprintf(stderr, "-m takes pattern names or numbers 0..%d\n", PATTERN_NUM - 1);
+          return 2;
+        }
+        is_mode_given = true;
+        break;
+      case 'S': is_master = 0; break;
+      default:
+        fprintf(stderr, "usage: %s [-x speed] [-m mode[,mode...]] [-S] keytrace\n", argv[0]);
+        return 2;
+    }
+  }
+  if (optind + 1 != argc) {
+    fprintf(stderr, "usage: %s [-x speed] [-m mode[,mode...]] [-S] keytrace\n", argv[0]);
+    return 2;
+  }
+  if (!is_mode_given) {
+    memset(options.modes, true, sizeof(options.modes));
+  }
+
+  struct Replay replay;
+  if (replay_map(&replay, argv[optind]) < 0) {
+    return 1;
+  }
+
+  printf("# %u events over %.1f s, speed x%u%s, half=%s\n",
+         replay.event_num, replay.duration / 1000., options.speed,
+         options.speed ? "" : " (unpaced)", is_master ? "master" : "slave");
+  printf("%-10s %8s %9s %9s %10s %10s %10s %5s %8s %8s\n",
+         "pattern", "events", "host s", "x real", "ns/scan", "ns/event", "led_sets", "peak", "evicted", "merged");
+
+  for (int mode = 0; mode < PATTERN_NUM; mode++) {
+    if (!options.modes[mode]) {
+      continue;
+    }
+    struct Result result = { 0 };
+    replay_pattern(mode, &replay, &result);
+    if (result.is_broken) {
+      fprintf(stderr, "%s: broken record after %u events\n", argv[optind], result.events);
+      return 1;
+    }
+    const struct MatledPressedCounts *pressed = matled_get_pressed_counts();
+    printf("%-10s %8u %9.2f %9.0f %10.1f %10.1f %10u %5u %8u %8u\n", pattern_names[mode], result.events,
+           result.host_ns / 1e9,
+           result.host_ns ? host_timer_ms * 1e6 / result.host_ns : 0.,
+           result.scans  ? (double)(result.host_ns - result.sleep_ns) / result.scans : 0.,
+           result.events ? (double)result.event_ns / result.events : 0.,
+           host_rgblight_set_count, pressed->peak, pressed->evicted, pressed->coalesced);
+  }
+
+  return 0;
+}
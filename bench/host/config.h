@@ -0,0 +1,38 @@
+// Host stand-in for keyboards/helix/rev2/config.h
+//   Reached through "../../config.h" at the end of the keymap's config.h,
+//   the Makefile puts bench/host/qmk/include on the include path for that.
+#ifndef REV2_CONFIG_H
+#define REV2_CONFIG_H
+
+#define MATRIX_ROWS (HELIX_ROWS * 2)
+#define MATRIX_COLS 7
+
+#ifdef OLED_ENABLE
+# define SSD1306OLED
+#endif
+
+#if defined(RGBLED_BACK)
+# if HELIX_ROWS == 5
+#  define RGBLED_NUM 32
+# else
+#  define RGBLED_NUM 25
+# endif
+#else
+# define RGBLED_NUM 6
+#endif
+
+#ifndef IOS_DEVICE_ENABLE
+# if RGBLED_NUM <= 6
+#  define RGBLIGHT_LIMIT_VAL 255
+# else
+#  if HELIX_ROWS == 5
+#   define RGBLIGHT_LIMIT_VAL 120
+#  else
+#   define RGBLIGHT_LIMIT_VAL 130
+#  endif
+# endif
+#else
+# define RGBLIGHT_LIMIT_VAL 50
+#endif
+
+#endif /* REV2_CONFIG_H */
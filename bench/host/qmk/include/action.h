@@ -0,0 +1,23 @@
+// Host stand-in for tmk_core/common/action.h
+#ifndef ACTION_H
+#define ACTION_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct {
+  uint8_t col;
+  uint8_t row;
+} keypos_t;
+
+typedef struct {
+  keypos_t key;
+  bool     pressed;
+  uint16_t time;
+} keyevent_t;
+
+typedef struct {
+  keyevent_t event;
+} keyrecord_t;
+
+#endif //ACTION_H
@@ -0,0 +1,7 @@
+// Host stand-in for tmk_core/common/bootloader.h
+#ifndef BOOTLOADER_H
+#define BOOTLOADER_H
+
+void bootloader_jump(void);
+
+#endif //BOOTLOADER_H
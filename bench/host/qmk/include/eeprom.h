@@ -0,0 +1,22 @@
+// Host stand-in for tmk_core/common/eeprom.h
+//   The host EEPROM (bench/host/qmk_host.c) takes EEPROM_WRITE_TIME of
+//   synthetic time per byte write, like the ATmega32u4 does.
+#ifndef TMK_CORE_COMMON_EEPROM_H_
+#define TMK_CORE_COMMON_EEPROM_H_
+
+#if defined(__AVR__)
+# include <avr/eeprom.h>
+#else
+# include <stdint.h>
+# include <stdbool.h>
+
+# define EEPROM_SIZE        1024
+# define EEPROM_WRITE_TIME  4     // ms, 3.3 ms rounded up to the timer
+
+bool eeprom_is_ready(void);
+uint8_t eeprom_read_byte(const uint8_t *addr);
+void eeprom_write_byte(uint8_t *addr, uint8_t value);   // waits for the previous write
+void eeprom_update_byte(uint8_t *addr, uint8_t value);
+#endif
+
+#endif //TMK_CORE_COMMON_EEPROM_H_
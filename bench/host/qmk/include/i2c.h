@@ -0,0 +1,18 @@
+// Host stand-in for keyboards/helix/i2c.h
+#ifndef I2C_H
+#define I2C_H
+
+#include <stdint.h>
+
+#define I2C_READ 1
+#define I2C_WRITE 0
+
+#define I2C_ACK 1
+#define I2C_NACK 0
+
+// returns 0 on success, like the AVR master
+uint8_t i2c_master_start(uint8_t address);
+void i2c_master_stop(void);
+uint8_t i2c_master_write(uint8_t data);
+
+#endif //I2C_H
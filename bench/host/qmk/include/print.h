@@ -0,0 +1,12 @@
+// Host stand-in for tmk_core/common/print.h, the console is stdout
+#ifndef PRINT_H
+#define PRINT_H
+
+#include <stdio.h>
+
+#define print(s)            fputs((s), stdout)
+#define println(s)          puts(s)
+#define print_hex8(i)       printf("%02X", (unsigned)(uint8_t)(i))
+#define print_hex16(i)      printf("%04X", (unsigned)(uint16_t)(i))
+
+#endif //PRINT_H
@@ -0,0 +1,142 @@
+// Host stand-in for QMK_KEYBOARD_H.
+//   Declares just enough of quantum/ and tmk_core/ to build this keymap on
+//   Linux, the definitions live in bench/host/qmk_host.c.
+#ifndef QMK_HOST_H
+#define QMK_HOST_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "action.h"
+#ifdef RGBLIGHT_ENABLE
+# include "rgblight.h"
+#endif
+
+// avr/pgmspace.h
+#ifdef __AVR__
+# include <avr/pgmspace.h>
+#else
+# define PROGMEM
+# define PSTR(s)                  (s)
+# define pgm_read_byte(addr)      (*(const uint8_t *)(addr))
+# define pgm_read_word(addr)      (*(const uint16_t *)(addr))
+#endif
+
+// timer.h
+#define TIMER_DIFF(a, b, max)   ((a) >= (b) ?  (a) - (b) : (max) - (b) + (a))
+#define TIMER_DIFF_8(a, b)      TIMER_DIFF(a, b, UINT8_MAX)
+#define TIMER_DIFF_16(a, b)     TIMER_DIFF(a, b, UINT16_MAX)
+#define TIMER_DIFF_32(a, b)     TIMER_DIFF(a, b, UINT32_MAX)
+uint16_t timer_read(void);
+uint32_t timer_read32(void);
+uint16_t timer_elapsed(uint16_t last);
+uint32_t timer_elapsed32(uint32_t last);
+
+// matrix.h
+typedef uint8_t matrix_row_t;
+bool matrix_is_on(uint8_t row, uint8_t col);
+matrix_row_t matrix_get_row(uint8_t row);
+
+// eeconfig.h
+#define EECONFIG_DEFAULT_LAYER  (uint8_t *)3
+#define EECONFIG_RGBLIGHT       (uint32_t *)8
+void eeconfig_update_default_layer(uint8_t val);
+
+// action_layer.h
+extern uint32_t layer_state;
+extern uint32_t default_layer_state;
+void layer_clear(void);
+
+// split_util.h
+bool has_usb(void);
+
+// helix.h, rev2 5-row layout
+#define LAYOUT( \
+  L00, L01, L02, L03, L04, L05,           R00, R01, R02, R03, R04, R05, \
+  L10, L11, L12, L13, L14, L15,           R10, R11, R12, R13, R14, R15, \
+  L20, L21, L22, L23, L24, L25,           R20, R21, R22, R23, R24, R25, \
+  L30, L31, L32, L33, L34, L35, L36, R36, R30, R31, R32, R33, R34, R35, \
+  L40, L41, L42, L43, L44, L45, L46, R46, R40, R41, R42, R43, R44, R45  \
+  ) \
+  { \
+    { L00, L01, L02, L03, L04, L05, KC_NO }, \
+    { L10, L11, L12, L13, L14, L15, KC_NO }, \
+    { L20, L21, L22, L23, L24, L25, KC_NO }, \
+    { L30, L31, L32, L33, L34, L35, L36 }, \
+    { L40, L41, L42, L43, L44, L45, L46 }, \
+    { R05, R04, R03, R02, R01, R00, KC_NO }, \
+    { R15, R14, R13, R12, R11, R10, KC_NO }, \
+    { R25, R24, R23, R22, R21, R20, KC_NO }, \
+    { R35, R34, R33, R32, R31, R30, R36 }, \
+    { R45, R44, R43, R42, R41, R40, R46 }  \
+  }
+
+// keycode.h, quantum_keycodes.h
+//   The values only need to be distinct, they are never sent to a host.
+enum hid_keyboard_keypad_usage {
+  KC_NO = 0x00,
+  KC_TRNS,
+  KC_A = 0x04, KC_B, KC_C, KC_D, KC_E, KC_F, KC_G, KC_H, KC_I, KC_J, KC_K,
+  KC_L, KC_M, KC_N, KC_O, KC_P, KC_Q, KC_R, KC_S, KC_T, KC_U, KC_V, KC_W,
+  KC_X, KC_Y, KC_Z,
+  KC_1, KC_2, KC_3, KC_4, KC_5, KC_6, KC_7, KC_8, KC_9, KC_0,
+  KC_ENT, KC_ESC, KC_BSPC, KC_TAB, KC_SPACE, KC_MINS, KC_EQL, KC_LBRC,
+  KC_RBRC, KC_BSLS, KC_NUHS, KC_SCLN, KC_QUOT, KC_GRV, KC_COMM, KC_DOT,
+  KC_SLSH,
+  KC_HOME = 0x4A, KC_PGUP, KC_DEL, KC_END, KC_PGDN, KC_RGHT, KC_LEFT,
+  KC_DOWN, KC_UP,
+  KC_MUTE = 0xA8, KC_VOLU, KC_VOLD, KC_MNXT, KC_MPRV, KC_MSTP, KC_MPLY,
+  KC_MSEL, KC_EJCT, KC_MAIL, KC_CALC, KC_MYCM, KC_WSCH, KC_WHOM, KC_WBAK,
+  KC_WFWD, KC_WSTP, KC_WREF, KC_WFAV, KC_MFFD, KC_MRWD,
+};
+
+#define MOD_LCTL  0x01
+#define MOD_LSFT  0x02
+#define MOD_LALT  0x04
+#define MOD_LGUI  0x08
+#define MOD_RCTL  0x11
+#define MOD_RSFT  0x12
+#define MOD_RALT  0x14
+#define MOD_RGUI  0x18
+
+enum quantum_keycodes {
+  QK_LCTL             = 0x0100,
+  QK_TO               = 0x5000,
+  QK_MOMENTARY        = 0x5100,
+  QK_DEF_LAYER        = 0x5200,
+  QK_ONE_SHOT_MOD     = 0x5500,
+  QK_MOD_TAP          = 0x6000,
+  RGB_TOG             = 0x5C00,
+  RGB_MODE_FORWARD,
+  RGB_HUI,
+  RGB_HUD,
+  RGB_SAI,
+  RGB_SAD,
+  RGB_VAI,
+  RGB_VAD,
+  SAFE_RANGE,
+};
+#define RGB_MOD           RGB_MODE_FORWARD
+#define LCTL(kc)          (QK_LCTL | (kc))
+#define TO(layer)         (QK_TO | (1 << 4) | ((layer) & 0xFF))
+#define MO(layer)         (QK_MOMENTARY | ((layer) & 0xFF))
+#define DF(layer)         (QK_DEF_LAYER | ((layer) & 0xFF))
+#define OSM(mod)          (QK_ONE_SHOT_MOD | ((mod) & 0xFF))
+#define MT(mod, kc)       (QK_MOD_TAP | (((mod) & 0x1F) << 8) | ((kc) & 0xFF))
+
+// Host control, used by the bench drivers only
+extern uint32_t host_timer_ms;
+extern uint32_t host_rgblight_set_count;
+extern uint32_t host_eeprom_write_count;  // bytes written
+extern uint32_t host_eeprom_wait_ms;      // a write waited for the previous one
+extern uint32_t host_i2c_byte_count;     // bytes on the bus, address bytes included
+#ifndef __AVR__
+  extern uint8_t host_oled_gddram[4][128]; // what the SSD1306 shows, pages x columns
+#endif
+void host_reset(void);
+void host_matrix_set(uint8_t row, uint8_t col, bool on);
+
+#endif //QMK_HOST_H
@@ -0,0 +1,36 @@
+// Host stand-in for quantum/rgblight.h
+#ifndef RGBLIGHT_H
+#define RGBLIGHT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct cRGB {
+  uint8_t g;
+  uint8_t r;
+  uint8_t b;
+} LED_TYPE;
+
+typedef union {
+  uint32_t raw;
+  struct {
+    bool     enable  :1;
+    uint8_t  mode    :6;
+    uint16_t hue     :9;
+    uint8_t  sat     :8;
+    uint8_t  val     :8;
+    uint8_t  speed   :8;
+  };
+} rgblight_config_t;
+
+void sethsv(uint16_t hue, uint8_t sat, uint8_t val, LED_TYPE *led1);
+void rgblight_set(void);
+void rgblight_sethsv(uint16_t hue, uint8_t sat, uint8_t val);
+void rgblight_enable(void);
+void rgblight_disable(void);
+
+uint32_t eeconfig_read_rgblight(void);
+void eeconfig_update_rgblight(uint32_t val);
+void eeconfig_update_rgblight_default(void);
+
+#endif //RGBLIGHT_H
@@ -0,0 +1,420 @@
+// Host stand-ins for the QMK functions and variables used by this keymap.
+//   Time is synthetic: it only moves when a bench driver writes host_timer_ms.
+#include "config.h"
+
+#include "qmk_host.h"
+#include "rgblight.h"
+#include "ssd1306.h"
+#include "i2c.h"
+#include "eeprom.h"
+#include "helixfont.h"
+
+uint32_t host_timer_ms;
+uint32_t host_rgblight_set_count;
+uint32_t host_eeprom_write_count;
+uint32_t host_eeprom_wait_ms;
+uint32_t host_i2c_byte_count;
+#ifndef __AVR__
+  uint8_t host_oled_gddram[DisplayHeight / 8][DisplayWidth];  // 512 bytes, more than the ATmega32u4 can spare
+#endif
+
+static matrix_row_t host_matrix[MATRIX_ROWS];
+#ifndef __AVR__
+  static uint8_t host_eeprom[EEPROM_SIZE];
+  static uint32_t host_eeprom_ready_time;   // host_timer_ms the last write is done at
+#endif
+
+void host_reset(void)
+{
+  host_timer_ms = 0u;
+  host_rgblight_set_count = 0u;
+  host_eeprom_write_count = 0u;
+  host_eeprom_wait_ms = 0u;
+  host_i2c_byte_count = 0u;
+  memset(host_matrix, 0, sizeof(host_matrix));
+  #ifndef __AVR__
+    memset(host_oled_gddram, 0, sizeof(host_oled_gddram));
+    memset(host_eeprom, 0, sizeof(host_eeprom));
+    host_eeprom_ready_time = 0u;
+  #endif
+}
+
+void host_matrix_set(uint8_t row, uint8_t col, bool on)
+{
+  if (on) {
+    host_matrix[row] |= (matrix_row_t)(1u << col);
+  }
+  else {
+    host_matrix[row] &= (matrix_row_t)~(1u << col);
+  }
+}
+
+// timer.c
+uint16_t timer_read(void)                   { return (uint16_t)host_timer_ms; }
+uint32_t timer_read32(void)                 { return host_timer_ms; }
+uint16_t timer_elapsed(uint16_t last)       { return TIMER_DIFF_16(timer_read(), last); }
+uint32_t timer_elapsed32(uint32_t last)     { return TIMER_DIFF_32(timer_read32(), last); }
+
+// matrix.c
+uint8_t is_master = 1;
+bool matrix_is_on(uint8_t row, uint8_t col) { return (host_matrix[row] >> col) & 1u; }
+matrix_row_t matrix_get_row(uint8_t row)    { return host_matrix[row]; }
+bool has_usb(void)                          { return true; }
+
+// action_layer.c
+uint32_t layer_state;
+uint32_t default_layer_state;
+void layer_clear(void)                      { layer_state = 0u; }
+
+// eeprom.h, see there for the timing
+#ifndef __AVR__
+bool eeprom_is_ready(void)
+{
+  return (int32_t)(host_timer_ms - host_eeprom_ready_time) >= 0;
+}
+
+uint8_t eeprom_read_byte(const uint8_t *addr)
+{
+  return host_eeprom[(uintptr_t)addr % EEPROM_SIZE];
+}
+
+void eeprom_write_byte(uint8_t *addr, uint8_t value)
+{
+  if (!eeprom_is_ready()) {
+    host_eeprom_wait_ms += host_eeprom_ready_time - host_timer_ms;
+    host_eeprom_ready_time += EEPROM_WRITE_TIME;
+  }
+  else {
+    host_eeprom_ready_time = host_timer_ms + EEPROM_WRITE_TIME;
+  }
+  host_eeprom[(uintptr_t)addr % EEPROM_SIZE] = value;
+  host_eeprom_write_count++;
+}
+
+void eeprom_update_byte(uint8_t *addr, uint8_t value)
+{
+  if (eeprom_read_byte(addr) != value) {
+    eeprom_write_byte(addr, value);
+  }
+}
+#endif
+
+// eeconfig.c, eeprom_update_dword() byte by byte
+void eeconfig_update_default_layer(uint8_t val)
+{
+  eeprom_update_byte(EECONFIG_DEFAULT_LAYER, val);
+}
+
+// rgblight.c
+rgblight_config_t rgblight_config;
+LED_TYPE led[RGBLED_NUM];
+
+uint32_t eeconfig_read_rgblight(void)
+{
+  uint32_t val = 0u;
+  for (int idx = 3; idx >= 0; idx--) {
+    val = (val << 8) | eeprom_read_byte((uint8_t *)EECONFIG_RGBLIGHT + idx);
+  }
+  return val;
+}
+
+void eeconfig_update_rgblight(uint32_t val)
+{
+  for (int idx = 0; idx < 4; idx++, val >>= 8) {
+    eeprom_update_byte((uint8_t *)EECONFIG_RGBLIGHT + idx, val);
+  }
+}
+
+void eeconfig_update_rgblight_default(void)
+{
+  rgblight_config.raw = 0u;
+  rgblight_config.enable = 1;
+  rgblight_config.mode = 0;
+  rgblight_config.hue = 0;
+  rgblight_config.sat = 255;
+  rgblight_config.val = RGBLIGHT_LIMIT_VAL;
+  eeconfig_update_rgblight(rgblight_config.raw);
+}
+
+void sethsv(uint16_t hue, uint8_t sat, uint8_t val, LED_TYPE *led1)
+{
+  uint8_t r = 0, g = 0, b = 0, base, color;
+
+  if (val > RGBLIGHT_LIMIT_VAL) {
+    val = RGBLIGHT_LIMIT_VAL;
+  }
+
+  if (sat == 0) {
+    r = val;
+    g = val;
+    b = val;
+  }
+  else {
+    base = ((255 - sat) * val) >> 8;
+    color = (val - base) * (hue % 60) / 60;
+
+    switch (hue / 60) {
+      case 0: r = val;          g = base + color; b = base;         break;
+      case 1: r = val - color;  g = val;          b = base;         break;
+      case 2: r = base;         g = val;          b = base + color; break;
+      case 3: r = base;         g = val - color;  b = val;          break;
+      case 4: r = base + color; g = base;         b = val;          break;
+      case 5: r = val;          g = base;         b = val - color;  break;
+    }
+  }
+
+  led1->r = r;
+  led1->g = g;
+  led1->b = b;
+}
+
+void rgblight_set(void)
+{
+  host_rgblight_set_count++;
+  #ifdef __AVR__
+    // ws2812 sends 24 bits of 1.25us each per LED with interrupts off
+    __builtin_avr_delay_cycles(RGBLED_NUM * 24ul * (F_CPU / 800000ul));
+  #endif
+}
+
+void rgblight_sethsv(uint16_t hue, uint8_t sat, uint8_t val)
+{
+  rgblight_config.hue = hue;
+  rgblight_config.sat = sat;
+  rgblight_config.val = val;
+  for (int idx = 0; idx < RGBLED_NUM; idx++) {
+    sethsv(hue, sat, val, &led[idx]);
+  }
+  rgblight_set();
+}
+
+void rgblight_enable(void)
+{
+  rgblight_config.enable = 1;
+  eeconfig_update_rgblight(rgblight_config.raw);
+}
+
+void rgblight_disable(void)
+{
+  rgblight_config.enable = 0;
+  eeconfig_update_rgblight(rgblight_config.raw);
+}
+
+// i2c.c, with a write-only SSD1306 on the bus
+//   Understands the control byte, PageAddr/ColumnAddr windows and GDDRAM
+//   data in horizontal addressing mode; other commands are taken as 1 byte.
+static struct {
+  uint8_t byte_idx;       // in the current transfer, 0 is the control byte
+  bool is_data;
+  uint8_t cmd[3];
+  uint8_t cmd_len;
+  uint8_t page_begin, page_end, page;
+  uint8_t col_begin, col_end, col;
+} host_ssd1306 = {
+  .page_end = DisplayHeight / 8 - 1,
+  .col_end  = DisplayWidth - 1,
+};
+
+static void host_ssd1306_command(uint8_t data)
+{
+  host_ssd1306.cmd[host_ssd1306.cmd_len++] = data;
+  uint8_t const cmd = host_ssd1306.cmd[0];
+  if ( (cmd == PageAddr || cmd == ColumnAddr) && host_ssd1306.cmd_len < 3 ) {
+    return;
+  }
+  if (cmd == PageAddr) {
+    host_ssd1306.page = host_ssd1306.page_begin = host_ssd1306.cmd[1] % (DisplayHeight / 8);
+    host_ssd1306.page_end = host_ssd1306.cmd[2] % (DisplayHeight / 8);
+  }
+  else if (cmd == ColumnAddr) {
+    host_ssd1306.col = host_ssd1306.col_begin = host_ssd1306.cmd[1] % DisplayWidth;
+    host_ssd1306.col_end = host_ssd1306.cmd[2] % DisplayWidth;
+  }
+  host_ssd1306.cmd_len = 0;
+}
+
+static void host_ssd1306_data(uint8_t data)
+{
+  #ifndef __AVR__
+    host_oled_gddram[host_ssd1306.page][host_ssd1306.col] = data;
+  #endif
+  if (host_ssd1306.col++ == host_ssd1306.col_end) {
+    host_ssd1306.col = host_ssd1306.col_begin;
+    if (host_ssd1306.page++ == host_ssd1306.page_end) {
+      host_ssd1306.page = host_ssd1306.page_begin;
+    }
+  }
+}
+
+// 9 clocks per byte at the 400kHz SCL_CLOCK of keyboards/helix/i2c.h
+static inline void host_i2c_byte_time(void)
+{
+  #ifdef __AVR__
+    __builtin_avr_delay_cycles(9ul * (F_CPU / 400000ul));
+  #endif
+}
+
+uint8_t i2c_master_start(uint8_t address)
+{
+  (void)address;
+  host_i2c_byte_count++;
+  host_i2c_byte_time();
+  host_ssd1306.byte_idx = 0;
+  host_ssd1306.cmd_len = 0;
+  return 0;
+}
+
+void i2c_master_stop(void)
+{
+}
+
+uint8_t i2c_master_write(uint8_t data)
+{
+  host_i2c_byte_count++;
+  host_i2c_byte_time();
+  if (host_ssd1306.byte_idx++ == 0) {
+    host_ssd1306.is_data = (data & 0x40);
+  }
+  else if (host_ssd1306.is_data) {
+    host_ssd1306_data(data);
+  }
+  else {
+    host_ssd1306_command(data);
+  }
+  return 0;
+}
+
+// ssd1306.c, the transfers of keyboards/helix/ssd1306.c
+struct CharacterMatrix display;
+
+static void send_cmd1(uint8_t cmd)
+{
+  i2c_master_start((SSD1306_ADDRESS << 1) | I2C_WRITE);
+  i2c_master_write(0x0 /* command byte follows */);
+  i2c_master_write(cmd);
+  i2c_master_stop();
+}
+
+static void send_cmd3(uint8_t cmd, uint8_t opr1, uint8_t opr2)
+{
+  send_cmd1(cmd);
+  send_cmd1(opr1);
+  send_cmd1(opr2);
+}
+
+bool iota_gfx_init(bool rotate)
+{
+  (void)rotate;
+  // clear_display()
+  matrix_clear(&display);
+  send_cmd3(PageAddr, 0, (DisplayHeight / 8) - 1);
+  send_cmd3(ColumnAddr, 0, DisplayWidth - 1);
+  i2c_master_start((SSD1306_ADDRESS << 1) | I2C_WRITE);
+  i2c_master_write(0x40);
+  for (uint16_t idx = 0; idx < (DisplayHeight / 8) * DisplayWidth; idx++) {
+    i2c_master_write(0);
+  }
+  i2c_master_stop();
+  display.dirty = false;
+  return true;
+}
+
+bool iota_gfx_on(void)                      { send_cmd1(DisplayOn); return true; }
+bool iota_gfx_off(void)                     { send_cmd1(DisplayOff); return true; }
+
+void matrix_clear(struct CharacterMatrix *matrix)
+{
+  memset(matrix->display, ' ', sizeof(matrix->display));
+  matrix->cursor = &matrix->display[0][0];
+  matrix->dirty = true;
+}
+
+void matrix_write_char_inner(struct CharacterMatrix *matrix, uint8_t c)
+{
+  *matrix->cursor = c;
+  ++matrix->cursor;
+
+  if (matrix->cursor - &matrix->display[0][0] == sizeof(matrix->display)) {
+    memmove(&matrix->display[0], &matrix->display[1], MatrixCols * (MatrixRows - 1));
+    matrix->cursor = &matrix->display[MatrixRows - 1][0];
+    memset(matrix->cursor, ' ', MatrixCols);
+  }
+}
+
+void matrix_write_char(struct CharacterMatrix *matrix, uint8_t c)
+{
+  matrix->dirty = true;
+
+  if (c == '\n') {
+    uint8_t cursor_col = (matrix->cursor - &matrix->display[0][0]) % MatrixCols;
+    while (cursor_col++ < MatrixCols) {
+      matrix_write_char_inner(matrix, ' ');
+    }
+    return;
+  }
+
+  matrix_write_char_inner(matrix, c);
+}
+
+void matrix_write(struct CharacterMatrix *matrix, const char *data)
+{
+  const char *end = data + strlen(data);
+  while (data < end) {
+    matrix_write_char(matrix, *data);
+    ++data;
+  }
+}
+
+void matrix_write_P(struct CharacterMatrix *matrix, const char *data)
+{
+  while (true) {
+    uint8_t c = pgm_read_byte(data);
+    if (c == 0) {
+      return;
+    }
+    matrix_write_char(matrix, c);
+    ++data;
+  }
+}
+
+void matrix_render(struct CharacterMatrix *matrix)
+{
+  iota_gfx_on();
+
+  // Move to the home position
+  send_cmd3(PageAddr, 0, MatrixRows - 1);
+  send_cmd3(ColumnAddr, 0, (MatrixCols * FontWidth) - 1);
+
+  i2c_master_start((SSD1306_ADDRESS << 1) | I2C_WRITE);
+  i2c_master_write(0x40);
+  for (uint8_t row = 0; row < MatrixRows; ++row) {
+    for (uint8_t col = 0; col < MatrixCols; ++col) {
+      const uint8_t *glyph = font + (matrix->display[row][col] * FontWidth);
+      for (uint8_t glyphCol = 0; glyphCol < FontWidth; ++glyphCol) {
+        i2c_master_write(pgm_read_byte(glyph + glyphCol));
+      }
+    }
+  }
+  matrix->dirty = false;
+  i2c_master_stop();
+}
+
+void iota_gfx_flush(void)
+{
+  matrix_render(&display);
+}
+
+void iota_gfx_clear_screen(void)
+{
+  matrix_clear(&display);
+  iota_gfx_flush();
+}
+
+void iota_gfx_task(void)
+{
+  iota_gfx_task_user();
+
+  if (display.dirty) {
+    iota_gfx_flush();
+  }
+}
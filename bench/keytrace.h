@@ -0,0 +1,114 @@
+#ifndef KEYTRACE_H
+#define KEYTRACE_H
+
+// Binary key trace, a recording of typing for the bench drivers
+//   trace_decode -k writes it from the console trace, bench_replay and
+//   bench_latency -f read it.
+//
+//   header: struct KeyTraceHeader, little endian
+//   record: one key byte, pressed << 7 | (row * MATRIX_COLS + col),
+//           then the ms since the previous record (the first: since the
+//           beginning of the trace) as a LEB128 varint, 7 bit per byte
+//           with bit 7 set on all but the last byte.
+//   Typing at up to 127 ms between events takes 2 bytes per event.
+//   Needs MATRIX_ROWS and MATRIX_COLS, include "config.h" first.
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#define KEYTRACE_MAGIC      "HXKT"
+#define KEYTRACE_VERSION    1
+#define KEYTRACE_KEY_NUM    128 // row * MATRIX_COLS + col must fit in 7 bit
+#define KEYTRACE_RECORD_MAX 6   // key byte and a 32 bit varint
+
+struct KeyTraceHeader {
+  char magic[4];
+  uint8_t version;
+  uint8_t matrix_rows;
+  uint8_t matrix_cols;
+  uint8_t reserved;
+  uint32_t event_num;
+  uint32_t duration;      // ms from the beginning to the last event
+};
+
+struct KeyTraceEvent {
+  uint32_t time;          // ms from the beginning
+  uint8_t row;
+  uint8_t col;
+  bool pressed;
+};
+
+_Static_assert(sizeof(struct KeyTraceHeader) == 16, "KeyTraceHeader is a file format");
+_Static_assert(MATRIX_ROWS * MATRIX_COLS <= KEYTRACE_KEY_NUM, "key index does not fit in a key byte");
+
+static inline void keytrace_header_init(struct KeyTraceHeader *header)
+{
+  memset(header, 0, sizeof(*header));
+  memcpy(header->magic, KEYTRACE_MAGIC, sizeof(header->magic));
+  header->version     = KEYTRACE_VERSION;
+  header->matrix_rows = MATRIX_ROWS;
+  header->matrix_cols = MATRIX_COLS;
+}
+
+// NULL if the header is fine for this build, else what is wrong
+static inline const char *keytrace_header_check(const struct KeyTraceHeader *header, size_t size)
+{
+  if (size < sizeof(*header) || memcmp(header->magic, KEYTRACE_MAGIC, sizeof(header->magic)) != 0) {
+    return "not a key trace";
+  }
+  if (header->version != KEYTRACE_VERSION) {
+    return "unknown key trace version";
+  }
+  if (header->matrix_rows != MATRIX_ROWS || header->matrix_cols != MATRIX_COLS) {
+    return "recorded with another matrix size";
+  }
+  return NULL;
+}
+
+// writes one record to buf, returns its length
+static inline size_t keytrace_encode(uint8_t *buf, uint32_t dt, uint8_t row, uint8_t col, bool pressed)
+{
+  size_t len = 0;
+  buf[len++] = (pressed ? 0x80 : 0x00) | (row * MATRIX_COLS + col);
+  do {
+    uint8_t const byte = dt & 0x7F;
+    dt >>= 7;
+    buf[len++] = byte | (dt ? 0x80 : 0x00);
+  } while (dt);
+  return len;
+}
+
+// reads one record at *it into event, advancing event->time by its dt,
+// returns false at the end or on a truncated or broken record
+static inline bool keytrace_decode(const uint8_t **it, const uint8_t *end, struct KeyTraceEvent *event)
+{
+  const uint8_t *p = *it;
+  if (p >= end) {
+    return false;
+  }
+  uint8_t const key = *p++;
+  uint32_t dt = 0;
+  for (int shift = 0; ; shift += 7) {
+    if (p >= end || shift > 28) {
+      return false;
+    }
+    uint8_t const byte = *p++;
+    dt |= (uint32_t)(byte & 0x7F) << shift;
+    if ( !(byte & 0x80) ) {
+      break;
+    }
+  }
+  uint8_t const idx = key & 0x7F;
+  if (idx >= MATRIX_ROWS * MATRIX_COLS) {
+    return false;
+  }
+  event->time   += dt;
+  event->row     = idx / MATRIX_COLS;
+  event->col     = idx % MATRIX_COLS;
+  event->pressed = key >> 7;
+  *it = p;
+  return true;
+}
+
+#endif //KEYTRACE_H
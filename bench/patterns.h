@@ -0,0 +1,27 @@
+// LightingPattern names in matrixled.c order, shared by the bench drivers
+#ifndef BENCH_PATTERNS_H
+#define BENCH_PATTERNS_H
+
+#include "matrixled.h"
+
+static const char * const pattern_names[] = {
+  "STATIC",
+  #ifdef ENABLE_MATLED_SWITCH_PATTERN
+    "SWITCH", "SWITCH_RB",
+  #endif
+  #ifdef ENABLE_MATLED_DIMLY_PATTERN
+    "DIMLY", "DIMLY_RB",
+  #endif
+  #ifdef ENABLE_MATLED_RIPPLE_PATTERN
+    "RIPPLE", "RIPPLE_RB",
+  #endif
+  #ifdef ENABLE_MATLED_CROSS_PATTERN
+    "CROSS", "CROSS_RB",
+  #endif
+  #ifdef ENABLE_MATLED_WAVE_PATTERN
+    "WAVE", "WAVE_RB",
+  #endif
+};
+#define PATTERN_NUM   ((int)(sizeof(pattern_names) / sizeof(pattern_names[0])))
+
+#endif //BENCH_PATTERNS_H
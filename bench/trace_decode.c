@@ -0,0 +1,295 @@
+// Decoder for the console trace of trace.c
+//   Picks the TRACE_LINE_PREFIX lines out of a hid_listen capture, unwraps
+//   the 16 bit ms timestamps and reports event counts, the latency from each
+//   key press to the next LED frame and from each layer change to the next
+//   OLED render.
+//
+//   usage: trace_decode [-t] [-k keytrace] [capture]
+//     -t  print the timeline as well
+//     -k  record the key events to a binary key trace, see keytrace.h
+//   Gaps of more than 65 s between two records can not be told apart from
+//   shorter ones, capture with something running (e.g. a LED pattern).
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "trace.h"
+#include "keytrace.h"
+
+#define RECORD_HEX_LEN      10
+#define PENDING_MAX         64  // events waiting for their frame or render
+
+#define TE_NAME_STR( name )  [TE_(name)] = #name
+static const char * const event_names[TE_NUM] = { APPLY_TRACE_EVENTS( TE_NAME_STR ) };
+
+struct Latency {
+  uint32_t *ms;
+  size_t num;
+  size_t cap;
+};
+
+// events not yet followed by the one a Latency waits for
+struct Pending {
+  uint64_t time[PENDING_MAX];
+  size_t num;
+};
+
+static struct {
+  bool is_timeline;
+  const char *keytrace_file;
+} options;
+
+// the key events going to options.keytrace_file
+static struct {
+  FILE *fp;
+  struct KeyTraceHeader header;
+  uint64_t first_time;
+  uint64_t last_time;
+} keytrace;
+
+static uint32_t event_counts[TE_NUM];
+static uint32_t unknown_count;
+static uint32_t dropped_count;
+
+static void latency_add(struct Latency *latency, uint32_t ms)
+{
+  if (latency->num == latency->cap) {
+    latency->cap = latency->cap ? latency->cap * 2 : 256;
+    latency->ms = realloc(latency->ms, latency->cap * sizeof(latency->ms[0]));
+    if (latency->ms == NULL) {
+      perror("realloc");
+      exit(1);
+    }
+  }
+  latency->ms[latency->num++] = ms;
+}
+
+static void pending_resolve(struct Pending *pending, struct Latency *latency, uint64_t time)
+{
+  for (size_t idx = 0; idx < pending->num; idx++) {
+    latency_add(latency, time - pending->time[idx]);
+  }
+  pending->num = 0;
+}
+
+static void pending_push(struct Pending *pending, uint64_t time)
+{
+  if (pending->num < PENDING_MAX) {
+    pending->time[pending->num++] = time;
+  }
+}
+
+static int compare_u32(const void *a, const void *b)
+{
+  uint32_t const x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+  return (x > y) - (x < y);
+}
+
+static void latency_report(const char *name, struct Latency *latency)
+{
+  if (latency->num == 0) {
+    printf("%-18s %8s\n", name, "-");
+    return;
+  }
+  qsort(latency->ms, latency->num, sizeof(latency->ms[0]), compare_u32);
+  printf("%-18s %8zu %8u %8u %8u\n", name, latency->num,
+         latency->ms[(latency->num - 1) * 50 / 100],
+         latency->ms[(latency->num - 1) * 99 / 100],
+         latency->ms[latency->num - 1]);
+}
+
+static void print_record(uint64_t time, uint8_t type, uint16_t payload)
+{
+  printf("%10.3f  %-12s ", time / 1000., (type < TE_NUM) ? event_names[type] : "?");
+  switch (type) {
+    case TE_(KEY_DOWN):
+    case TE_(KEY_UP):
+      printf("row %u col %u\n", payload >> 8, payload & 0xFF);
+      break;
+    case TE_(LED_REFRESH):
+      printf("mode %u%s\n", payload >> 8, (payload & 1) ? "" : " done");
+      break;
+    case TE_(LED_FRAME):
+      printf("mode %u\n", payload);
+      break;
+    case TE_(OLED_FLUSH):
+      printf("page %u, %u chars\n", payload >> 8, payload & 0xFF);
+      break;
+    case TE_(EEPROM):
+      printf("%s\n", (payload == TRACE_EEPROM_DEFAULT_LAYER) ? "default layer" : "rgblight");
+      break;
+    default:
+      printf("0x%04X\n", payload);
+      break;
+  }
+}
+
+static int keytrace_open(const char *file)
+{
+  keytrace.fp = fopen(file, "wb");
+  if (keytrace.fp == NULL) {
+    perror(file);
+    return -1;
+  }
+  // rewritten with the counts by keytrace_close()
+  keytrace_header_init(&keytrace.header);
+  fwrite(&keytrace.header, sizeof(keytrace.header), 1, keytrace.fp);
+  return 0;
+}
+
+static void keytrace_add(uint64_t time, uint16_t payload, bool pressed)
+{
+  uint8_t const row = payload >> 8, col = payload & 0xFF;
+  if (row >= MATRIX_ROWS || col >= MATRIX_COLS) {
+    return;
+  }
+  if (keytrace.header.event_num == 0u) {
+    keytrace.first_time = keytrace.last_time = time;
+  }
+  uint8_t buf[KEYTRACE_RECORD_MAX];
+  size_t const len = keytrace_encode(buf, time - keytrace.last_time, row, col, pressed);
+  fwrite(buf, 1, len, keytrace.fp);
+  keytrace.last_time = time;
+  keytrace.header.event_num++;
+}
+
+static int keytrace_close(const char *file)
+{
+  keytrace.header.duration = keytrace.last_time - keytrace.first_time;
+  rewind(keytrace.fp);
+  fwrite(&keytrace.header, sizeof(keytrace.header), 1, keytrace.fp);
+  if (ferror(keytrace.fp) | fclose(keytrace.fp)) {
+    perror(file);
+    return -1;
+  }
+  return 0;
+}
+
+static int hex_value(const char *str, int len)
+{
+  int value = 0;
+  for (int idx = 0; idx < len; idx++) {
+    char c = str[idx];
+    int digit = ('0' <= c && c <= '9') ? c - '0'
+              : ('A' <= c && c <= 'F') ? c - 'A' + 10
+              : ('a' <= c && c <= 'f') ? c - 'a' + 10
+              : -1;
+    if (digit < 0) {
+      return -1;
+    }
+    value = (value << 4) | digit;
+  }
+  return value;
+}
+
+int main(int argc, char *argv[])
+{
+  int opt;
+  while ((opt = getopt(argc, argv, "tk:")) != -1) {
+    switch (opt) {
+      case 't': options.is_timeline = true; break;
+      case 'k': options.keytrace_file = optarg; break;
+      default:
+        fprintf(stderr, "usage: %s [-t] [-k keytrace] [capture]\n", argv[0]);
+        return 2;
+    }
+  }
+  FILE *fp = stdin;
+  if (optind < argc) {
+    fp = fopen(argv[optind], "r");
+    if (fp == NULL) {
+      perror(argv[optind]);
+      return 1;
+    }
+  }
+  if (options.keytrace_file && keytrace_open(options.keytrace_file) < 0) {
+    return 1;
+  }
+
+  struct Latency to_led = { 0 }, to_oled = { 0 };
+  struct Pending led_pending = { 0 }, oled_pending = { 0 };
+  uint64_t time = 0;
+  uint16_t last_time16 = 0;
+  bool is_first = true;
+  uint32_t record_num = 0;
+
+  char line[1024];
+  while (fgets(line, sizeof(line), fp) != NULL) {
+    const char *it = strstr(line, TRACE_LINE_PREFIX);
+    if (it == NULL) {
+      continue;
+    }
+    it += strlen(TRACE_LINE_PREFIX);
+
+    for ( ; ; it += RECORD_HEX_LEN) {
+      int const type    = hex_value(it, 2);
+      int const time16  = hex_value(it + 2, 4);
+      int const payload = hex_value(it + 6, 4);
+      if (type < 0 || time16 < 0 || payload < 0) {
+        break;
+      }
+
+      time += is_first ? (uint64_t)time16 : (uint16_t)(time16 - last_time16);
+      last_time16 = time16;
+      is_first = false;
+      record_num++;
+
+      if (type >= TE_NUM) {
+        unknown_count++;
+        continue;
+      }
+      event_counts[type]++;
+      if (options.is_timeline) {
+        print_record(time, type, payload);
+      }
+
+      switch (type) {
+        case TE_(DROPPED):
+          dropped_count += payload;
+          break;
+        case TE_(KEY_DOWN):
+          pending_push(&led_pending, time);
+          /* FALLTHROUGH */
+        case TE_(KEY_UP):
+          if (keytrace.fp) {
+            keytrace_add(time, payload, type == TE_(KEY_DOWN));
+          }
+          break;
+        case TE_(LAYER):
+          pending_push(&oled_pending, time);
+          break;
+        case TE_(LED_FRAME):
+          pending_resolve(&led_pending, &to_led, time);
+          break;
+        case TE_(OLED_RENDER):
+          pending_resolve(&oled_pending, &to_oled, time);
+          break;
+      }
+    }
+  }
+
+  printf("# %u records over %.3f s, %u dropped, %u unknown\n",
+         record_num, time / 1000., dropped_count, unknown_count);
+  printf("%-18s %8s\n", "event", "count");
+  for (int type = 0; type < TE_NUM; type++) {
+    printf("%-18s %8u\n", event_names[type], event_counts[type]);
+  }
+  printf("%-18s %8s %8s %8s %8s\n", "latency ms", "n", "p50", "p99", "max");
+  latency_report("key->LED_FRAME", &to_led);
+  latency_report("layer->OLED_RENDER", &to_oled);
+
+  free(to_led.ms);
+  free(to_oled.ms);
+  if (keytrace.fp) {
+    printf("# %u key events to %s\n", keytrace.header.event_num, options.keytrace_file);
+    if (keytrace_close(options.keytrace_file) < 0) {
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -37,6 +37,14 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 # define HELIX_COLS             7
 #endif
 
+/* Scan run time on the OLED and the probes of profiler.h,
+   KC_PROF on the CONFIG layer pages through the probes. */
+//#define MATRIX_SCAN_RUN_TIME
+
+/* Event trace on the console, needs CONSOLE_ENABLE = yes in rules.mk.
+   Decode a hid_listen capture with bench/trace_decode, see trace.h. */
+//#define TRACE_ENABLE
+
 #include "../../config.h"
 
 #endif /* CONFIG_USER_H */
@@ -0,0 +1,113 @@
+#include "config.h"
+
+#include QMK_KEYBOARD_H
+#include "eeprom.h"
+#include "eecache.h"
+#include "trace.h"
+
+// cached bytes, in the byte order of eeprom_update_dword()
+enum eecache_byte {
+  EB_DEFAULT_LAYER,
+  EB_RGBLIGHT,          // 4 bytes, little endian
+  EB_NUM = EB_RGBLIGHT + 4
+};
+
+static uint8_t * const eecache_addr[EB_NUM] = {
+  [EB_DEFAULT_LAYER]    = (uint8_t *)EECONFIG_DEFAULT_LAYER,
+  [EB_RGBLIGHT + 0]     = (uint8_t *)EECONFIG_RGBLIGHT + 0,
+  [EB_RGBLIGHT + 1]     = (uint8_t *)EECONFIG_RGBLIGHT + 1,
+  [EB_RGBLIGHT + 2]     = (uint8_t *)EECONFIG_RGBLIGHT + 2,
+  [EB_RGBLIGHT + 3]     = (uint8_t *)EECONFIG_RGBLIGHT + 3,
+};
+
+// data: what the EEPROM should hold, dirty: bit per byte of data not yet
+// committed, last_update: timer_read() of the last change
+static struct {
+  uint8_t data[EB_NUM];
+  uint8_t dirty;
+  uint16_t last_update;
+} eecache;
+_Static_assert(EB_NUM <= 8 * sizeof(eecache.dirty), "eecache.dirty has a bit per byte");
+
+static struct EECacheCounts eecache_counts;
+
+static void eecache_store(uint8_t begin, uint32_t val, uint8_t len)
+{
+  for ( uint8_t idx = begin; idx < begin + len; idx++, val >>= 8 ) {
+    if ( eecache.data[idx] != (uint8_t)val ) {
+      eecache.data[idx] = val;
+      eecache.dirty |= (1u << idx);
+      eecache.last_update = timer_read();
+      eecache_counts.requested++;
+    }
+  }
+}
+
+// idx must be dirty, the EEPROM is ready when called from eecache_task()
+static void eecache_commit(uint8_t idx)
+{
+  eecache.dirty &= ~(1u << idx);
+  // a settled value may be back to what the EEPROM already holds
+  if ( eeprom_read_byte(eecache_addr[idx]) == eecache.data[idx] ) {
+    return;
+  }
+  eeprom_write_byte(eecache_addr[idx], eecache.data[idx]);
+  eecache_counts.committed++;
+  TRACE(EEPROM, (idx == EB_DEFAULT_LAYER) ? TRACE_EEPROM_DEFAULT_LAYER : TRACE_EEPROM_RGBLIGHT);
+}
+
+void eecache_init(void)
+{
+  for ( uint8_t idx = 0; idx < EB_NUM; idx++ ) {
+    eecache.data[idx] = eeprom_read_byte(eecache_addr[idx]);
+  }
+  eecache.dirty = 0u;
+}
+
+void eecache_update_default_layer(uint8_t val)
+{
+  eecache_store(EB_DEFAULT_LAYER, val, 1);
+}
+
+void eecache_update_rgblight(uint32_t val)
+{
+  eecache_store(EB_RGBLIGHT, val, 4);
+}
+
+void eecache_sync_rgblight(uint32_t val)
+{
+  for ( uint8_t idx = EB_RGBLIGHT; idx < EB_RGBLIGHT + 4; idx++, val >>= 8 ) {
+    eecache.data[idx] = val;
+    eecache.dirty &= ~(1u << idx);
+  }
+}
+
+// one byte per call, so a scan never waits for the EEPROM
+void eecache_task(void)
+{
+  if ( eecache.dirty == 0u
+       || timer_elapsed(eecache.last_update) < EECACHE_QUIET_TIME
+       || !eeprom_is_ready() ) {
+    return;
+  }
+
+  uint8_t idx = 0;
+  while ( !(eecache.dirty & (1u << idx)) ) {
+    idx++;
+  }
+  eecache_commit(idx);
+}
+
+void eecache_flush(void)
+{
+  for ( uint8_t idx = 0; eecache.dirty != 0u; idx++ ) {
+    if ( eecache.dirty & (1u << idx) ) {
+      eecache_commit(idx);    // eeprom_write_byte() waits for the previous write
+    }
+  }
+}
+
+const struct EECacheCounts *eecache_get_counts(void)
+{
+  return &eecache_counts;
+}
@@ -0,0 +1,30 @@
+#ifndef EECACHE_H
+#define EECACHE_H
+
+#include <stdint.h>
+
+// Write-back cache of the EEPROM settings the keymap changes at run time.
+// Updates only change RAM, eecache_task() writes the changed bytes one per
+// scan, and only while the EEPROM is idle, once nothing has changed for
+// EECACHE_QUIET_TIME. A byte write stalls the AVR for ~3.3ms when the
+// previous one is still running, and wears the cell.
+
+// config
+#define EECACHE_QUIET_TIME  3000  // ms without an update before the commit
+
+// bytes written by eeconfig_update_*() if the cache were not there,
+// minus the ones it committed, is what it saved
+struct EECacheCounts {
+  uint32_t requested;   // bytes changed by eecache_update_*()
+  uint32_t committed;   // bytes written to the EEPROM
+};
+
+void eecache_init(void);
+void eecache_update_default_layer(uint8_t val);
+void eecache_update_rgblight(uint32_t val);
+void eecache_sync_rgblight(uint32_t val);  // val was written behind the cache, e.g. by rgblight_enable()
+void eecache_task(void);    // from matrix_scan_user()
+void eecache_flush(void);   // writes everything now, blocks, e.g. on suspend
+const struct EECacheCounts *eecache_get_counts(void);
+
+#endif //EECACHE_H
@@ -8,7 +8,11 @@
 #endif
 #ifdef SSD1306OLED
   #include "ssd1306.h"
+  #include "oledtask.h"
 #endif
+#include "eecache.h"
+#include "profiler.h"
+#include "trace.h"
 
 
 #ifdef RGBLIGHT_ENABLE
@@ -35,7 +39,8 @@ enum keymap_layer {
 enum custom_keycodes {
   KC_LAYER = SAFE_RANGE,
   KC_ADJUST,
-  RGBRST
+  RGBRST,
+  KC_PROF     // next page of the profiler, the stats restart, MATRIX_SCAN_RUN_TIME only
 };
 
 #define _______ KC_TRNS
@@ -95,7 +100,7 @@ const uint16_t PROGMEM keymaps[][MATRIX_ROWS][MATRIX_COLS] = {
       ),
 
   [KL_(CONFIG)] = LAYOUT( \
-      XXXXXXX, XXXXXXX, XXXXXXX, XXXXXXX, XXXXXXX, XXXXXXX,                   XXXXXXX, XXXXXXX, XXXXXXX, XXXXXXX, XXXXXXX, XXXXXXX, \
+      XXXXXXX, KC_PROF, XXXXXXX, XXXXXXX, XXXXXXX, XXXXXXX,                   XXXXXXX, XXXXXXX, XXXXXXX, XXXXXXX, XXXXXXX, XXXXXXX, \
        KC_TAB, RGB_TOG, RGB_HUI, RGB_SAI, RGB_VAI,  RGBRST,                   XXXXXXX, XXXXXXX, XXXXXXX, XXXXXXX, XXXXXXX, XXXXXXX, \
       XXXXXXX, RGB_MOD, RGB_HUD, RGB_SAD, RGB_VAD, XXXXXXX,                   XXXXXXX, XXXXXXX, XXXXXXX, XXXXXXX, XXXXXXX, XXXXXXX, \
       XXXXXXX, DF_QWRT, DF_CURS, DF_MEDI, TO_CONF, XXXXXXX, XXXXXXX, XXXXXXX, XXXXXXX, XXXXXXX, XXXXXXX, XXXXXXX, XXXXXXX, XXXXXXX, \
@@ -156,6 +161,10 @@ user_modifiler_contains_idx( enum user_modifier mod_idx )
 #define PROCESS_USUAL_BEHAVIOR      (true)
 
 static keyrecord_t last_keyrecord;
+#ifdef MATRIX_SCAN_RUN_TIME
+  // OLED page, 0: status, n: profile_stats[n - 1]
+  static uint8_t profile_page;
+#endif
 static bool
 process_record_event(uint16_t keycode, keyrecord_t *record);
 
@@ -164,25 +173,29 @@ process_record_event(uint16_t keycode, keyrecord_t *record);
 bool
 process_record_user(uint16_t keycode, keyrecord_t *record)
 {
-  bool result_process;
+  PROFILE_BEGIN(PROCESS_RECORD);
+
+  if (record->event.pressed) {
+    TRACE(KEY_DOWN, (record->event.key.row << 8) | record->event.key.col);
+  }
+  else {
+    TRACE(KEY_UP, (record->event.key.row << 8) | record->event.key.col);
+  }
 
   last_keyrecord = *record;
 
   // check the event to be overridden
-  result_process = process_record_event(keycode, record);
-  if (result_process == PROCESS_OVERRIDE_BEHAVIOR) {
-    return PROCESS_OVERRIDE_BEHAVIOR;
-  }
+  bool result_process = process_record_event(keycode, record);
 
   #ifdef MATRIXLED_H
     // notice keypos to matled
-    result_process = matled_record_event(keycode, record);
-    if (result_process == PROCESS_OVERRIDE_BEHAVIOR) {
-      return PROCESS_OVERRIDE_BEHAVIOR;
+    if (result_process == PROCESS_USUAL_BEHAVIOR) {
+      result_process = matled_record_event(keycode, record);
     }
   #endif
 
-  return PROCESS_USUAL_BEHAVIOR;
+  PROFILE_END(PROCESS_RECORD);
+  return result_process;
 }
 
 static bool
@@ -194,12 +207,21 @@ process_record_event(uint16_t keycode, keyrecord_t *record)
       #ifdef RGBLIGHT_ENABLE
         eeconfig_update_rgblight_default();
         rgblight_enable();
+        TRACE(EEPROM, TRACE_EEPROM_RGBLIGHT);
+        eecache_sync_rgblight(rgblight_config.raw);
       #endif
       #ifdef MATRIXLED_H
         matled_init();
       #endif
     } break;
 
+    case KC_PROF: if (record->event.pressed) {
+      #ifdef MATRIX_SCAN_RUN_TIME
+        profile_page = (profile_page + 1) % (PP_NUM + 1);
+        profile_clear();
+      #endif
+    } break;
+
     case MO_CONF: {
       static uint32_t before_default_layer_state;
       if (record->event.pressed) {
@@ -208,7 +230,7 @@ process_record_event(uint16_t keycode, keyrecord_t *record)
       else {
         layer_clear();
         if (before_default_layer_state != default_layer_state) {
-          eeconfig_update_default_layer(default_layer_state);
+          eecache_update_default_layer(default_layer_state);
         }
       }
       return PROCESS_USUAL_BEHAVIOR;
@@ -221,18 +243,27 @@ process_record_event(uint16_t keycode, keyrecord_t *record)
   return PROCESS_USUAL_BEHAVIOR;
  }
 
+#ifdef SSD1306OLED
+static void
+render_inputs_invalidate(void);
+#endif
+
 //keyboard start-up code. Runs once when the firmware starts up.
 void matrix_init_user(void) {
+  eecache_init();
   #ifdef MATRIXLED_H
     matled_init();
   #endif
   //SSD1306 OLED init, make sure to add #define SSD1306OLED in config.h
   #ifdef SSD1306OLED
     iota_gfx_init(!has_usb());   // turns on the display
+    render_inputs_invalidate();  // the display was cleared, render on the next scan
+    #ifdef OLEDTASK_H
+      oled_init();
+    #endif
   #endif
 }
 
-//#define MATRIX_SCAN_RUN_TIME
 #ifdef MATRIX_SCAN_RUN_TIME
 static struct {
   uint32_t last_calc_time;
@@ -242,14 +273,33 @@ static struct {
   uint32_t cycle_time;
   uint32_t mean;
   uint32_t max;
+  #ifdef SSD1306OLED
+    uint32_t oled_progress_max;
+    uint32_t oled_max;    // worst single oled_task() of the last period
+  #endif
+  #ifdef MATRIXLED_H
+    uint32_t last_idle_time;
+    uint32_t idle_ratio;  // % of the last period the LED engine was idle
+  #endif
 } matrix_scan_run_time;
 static inline void matrix_scan_run_time_end(uint32_t begin_time);
+static inline void matrix_scan_run_time_oled(uint32_t begin_time);
 #endif
 
 void matrix_scan_user(void) {
   __attribute__ ((unused))
   uint32_t begin_time = timer_read32();
 
+  #ifdef TRACE_ENABLE
+    // layer changes are applied after process_record_user(), catch them here
+    static uint32_t traced_layer;
+    uint32_t layer = layer_state | default_layer_state;
+    if (layer != traced_layer) {
+      traced_layer = layer;
+      TRACE(LAYER, layer);
+    }
+  #endif
+
   #ifdef MATRIXLED_H
     matled_refresh_task();
   #endif
@@ -259,10 +309,31 @@ void matrix_scan_user(void) {
   #endif
 
   #ifdef SSD1306OLED
-    iota_gfx_task();  // this is what updates the display continuously
+    __attribute__ ((unused))
+    uint32_t oled_begin_time = timer_read32();
+    #ifdef OLEDTASK_H
+      oled_task();      // sends only the characters that have changed
+    #else
+      iota_gfx_task();  // this is what updates the display continuously
+    #endif
+    #ifdef MATRIX_SCAN_RUN_TIME
+      matrix_scan_run_time_oled(oled_begin_time);
+    #endif
+  #endif
+
+  eecache_task();     // settled settings, a byte per scan
+
+  #ifdef TRACE_ENABLE
+    trace_drain();
   #endif
 }
 
+// the cache would be lost with the power, USB suspend may be the last chance
+void suspend_power_down_user(void)
+{
+  eecache_flush();
+}
+
 #ifdef MATRIX_SCAN_RUN_TIME
 static inline void matrix_scan_run_time_end(uint32_t begin_time)
 {
@@ -277,6 +348,16 @@ static inline void matrix_scan_run_time_end(uint32_t begin_time)
     matrix_scan_run_time.cycle_time = TIMER_DIFF_32(begin_time, matrix_scan_run_time.last_calc_time) / matrix_scan_run_time.scan_num;
     matrix_scan_run_time.mean = matrix_scan_run_time.progress_sum / matrix_scan_run_time.scan_num;
     matrix_scan_run_time.max  = matrix_scan_run_time.progress_max;
+    #ifdef SSD1306OLED
+      matrix_scan_run_time.oled_max = matrix_scan_run_time.oled_progress_max;
+      matrix_scan_run_time.oled_progress_max = 0u;
+    #endif
+    #ifdef MATRIXLED_H
+      uint32_t idle_time = matled_get_idle_time();
+      matrix_scan_run_time.idle_ratio = 100u * (idle_time - matrix_scan_run_time.last_idle_time)
+                                        / TIMER_DIFF_32(begin_time, matrix_scan_run_time.last_calc_time);
+      matrix_scan_run_time.last_idle_time = idle_time;
+    #endif
 
     matrix_scan_run_time.last_calc_time = begin_time;
     matrix_scan_run_time.scan_num = 0u;
@@ -284,9 +365,16 @@ static inline void matrix_scan_run_time_end(uint32_t begin_time)
     matrix_scan_run_time.progress_max = 0u;
   }
 }
+
+static inline void matrix_scan_run_time_oled(uint32_t begin_time)
+{
+  uint32_t run_time = TIMER_DIFF_32(timer_read32(), begin_time);
+  matrix_scan_run_time.oled_progress_max = (matrix_scan_run_time.oled_progress_max > run_time) ? matrix_scan_run_time.oled_progress_max : run_time;
+}
 #endif
 
 // OLED image characters
+__attribute__ ((unused))
 static const char PROGMEM
   matrix_HELIX[] = {
      0x80,0x81,0x82,0x83,0x84,0x85,0x86,0x87,0x88,0x89,0x8a,0x8b,0x8c,0x8d,0x8e,0x8f,0x90,0x91,0x92,0x93,0x94
@@ -297,6 +385,7 @@ static const char PROGMEM
 enum MatrixIcon {
   MI_APPLE, MI_WINDOWS, MI_PENGUIN, MI_ANDROID
 };
+__attribute__ ((unused))
 static const char PROGMEM
   matrix_Icons[][2][3] = {
     [MI_APPLE] = {
@@ -331,27 +420,99 @@ render_status_LedParams(struct CharacterMatrix *matrix);
 #ifdef MATRIX_SCAN_RUN_TIME
   static void
   render_status_RunTime(struct CharacterMatrix *matrix);
+  static void
+  render_status_Profile(struct CharacterMatrix *matrix, enum profile_probe probe);
 #endif
+static void
+matrix_write_uint(struct CharacterMatrix *matrix, uint32_t value, uint8_t width, char pad);
+static void
+matrix_clip_line(struct CharacterMatrix *matrix, uint8_t *line);
 
 static void
 matrix_update(struct CharacterMatrix *dest,
               const struct CharacterMatrix *source);
 
+// Everything render_status() reads, all 32 bit so that memcmp() sees no padding.
+// iota_gfx_task_user() renders only when one of them has changed.
+static struct RenderInputs {
+  uint32_t layer;
+  uint32_t user_modifier_bits;
+  #ifdef RGBLIGHT_ENABLE
+    uint32_t rgblight_config;
+    uint32_t led_mode;
+  #endif
+  #ifdef MATRIX_SCAN_RUN_TIME
+    uint32_t run_time_calc_time;  // the stats change once per period only
+    uint32_t profile_page;
+  #endif
+} render_inputs;
+static bool render_inputs_is_valid;
+
+static void
+render_inputs_invalidate(void)
+{
+  render_inputs_is_valid = false;
+}
+
+static bool
+render_inputs_update(void)
+{
+  struct RenderInputs const inputs = {
+    .layer              = layer_state | default_layer_state,
+    .user_modifier_bits = user_modifier_bits,
+    #ifdef RGBLIGHT_ENABLE
+      .rgblight_config  = rgblight_config.raw,
+      #ifdef MATRIXLED_H
+        .led_mode       = matled_get_mode(),
+      #else
+        .led_mode       = rgblight_config.mode,
+      #endif
+    #endif
+    #ifdef MATRIX_SCAN_RUN_TIME
+      .run_time_calc_time = matrix_scan_run_time.last_calc_time,
+      .profile_page       = profile_page,
+    #endif
+  };
+
+  if ( render_inputs_is_valid && !memcmp(&render_inputs, &inputs, sizeof(inputs)) ) {
+    return false;
+  }
+  render_inputs = inputs;
+  render_inputs_is_valid = true;
+  return true;
+}
+
 // be called from iota_gfx_task
 void iota_gfx_task_user(void)
 {
+  if (!render_inputs_update()) {
+    return;
+  }
+  TRACE(OLED_RENDER, 0);
+
   struct CharacterMatrix matrix;
 
   matrix_clear(&matrix);
 
   render_status(&matrix);
 
-  matrix_update(&display, &matrix);
+  #ifdef OLEDTASK_H
+    oled_update(&matrix);
+  #else
+    matrix_update(&display, &matrix);
+  #endif
 }
 
 static void
 render_status(struct CharacterMatrix *matrix)
 {
+  #ifdef MATRIX_SCAN_RUN_TIME
+    if ( profile_page > 0 ) {
+      render_status_Profile(matrix, profile_page - 1);
+      return;
+    }
+  #endif
+
   render_status_Layer(matrix);
 
   matrix_write_PSTR(matrix, "\n");
@@ -413,9 +574,6 @@ render_status_UserMod(struct CharacterMatrix *matrix)
 static void
 render_status_LedParams(struct CharacterMatrix *matrix)
 {
-  char buf[16];
-  const size_t sizeof_buf = sizeof(buf);
-
   matrix_write_PSTR(matrix, "LedStt");
 
   #ifdef MATRIXLED_H
@@ -423,22 +581,18 @@ render_status_LedParams(struct CharacterMatrix *matrix)
   #else
     int led_mode = rgblight_config.mode;
   #endif
-  if ( snprintf(buf, sizeof_buf, ":%c%d", (rgblight_config.enable ? ' ' : '!')
-                                        , led_mode) > 0 ) {
-    matrix_write(matrix, buf);
-  }
+  matrix_write_char(matrix, ':');
+  matrix_write_char(matrix, (rgblight_config.enable ? ' ' : '!'));
+  matrix_write_uint(matrix, led_mode, 0, ' ');
 
-  if ( snprintf(buf, sizeof_buf, ":%d", rgblight_config.hue) > 0 ) {
-    matrix_write(matrix, buf);
-  }
+  matrix_write_char(matrix, ':');
+  matrix_write_uint(matrix, rgblight_config.hue, 0, ' ');
 
-  if ( snprintf(buf, sizeof_buf, ":%d", rgblight_config.sat) > 0 ) {
-    matrix_write(matrix, buf);
-  }
+  matrix_write_char(matrix, ':');
+  matrix_write_uint(matrix, rgblight_config.sat, 0, ' ');
 
-  if ( snprintf(buf, sizeof_buf, ":%d", rgblight_config.val) > 0 ) {
-    matrix_write(matrix, buf);
-  }
+  matrix_write_char(matrix, ':');
+  matrix_write_uint(matrix, rgblight_config.val, 0, ' ');
 }
 #endif
 
@@ -446,23 +600,106 @@ render_status_LedParams(struct CharacterMatrix *matrix)
 static void
 render_status_RunTime(struct CharacterMatrix *matrix)
 {
-  char buf[16];
-  const size_t sizeof_buf = sizeof(buf);
+  // Run:<cycle>,<mean>,<max>,<oled max>,<LED idle>%
+  uint8_t *line = matrix->cursor;
+  matrix_write_PSTR(matrix, "Run:");
+
+  matrix_write_uint(matrix, matrix_scan_run_time.cycle_time, 0, ' ');
+  matrix_write_char(matrix, ',');
+  matrix_write_uint(matrix, matrix_scan_run_time.mean, 0, ' ');
+  matrix_write_char(matrix, ',');
+  matrix_write_uint(matrix, matrix_scan_run_time.max, 0, ' ');
+  matrix_write_char(matrix, ',');
+  #ifdef SSD1306OLED
+    matrix_write_uint(matrix, matrix_scan_run_time.oled_max, 0, ' ');
+    matrix_write_char(matrix, ',');
+  #endif
+  #ifdef MATRIXLED_H
+    matrix_write_uint(matrix, matrix_scan_run_time.idle_ratio, 3, ' ');
+    matrix_write_char(matrix, '%');
+  #endif
+  matrix_clip_line(matrix, line);
+}
+#endif
+
+#ifdef MATRIX_SCAN_RUN_TIME
+static void
+render_status_Profile(struct CharacterMatrix *matrix, enum profile_probe probe)
+{
+  const struct ProfileStat *stat = &profile_stats[probe];
 
-  matrix_write_PSTR(matrix, "RunTime:");
+  matrix_write_PSTR(matrix, "Prof:");
+  matrix_write_P(matrix, profile_name_P(probe));
 
-  if (snprintf(buf, sizeof_buf, "%ld,", matrix_scan_run_time.cycle_time) > 0) {
-    matrix_write(matrix, buf);
-  }
-  if (snprintf(buf, sizeof_buf, "%ld,", matrix_scan_run_time.mean) > 0) {
-    matrix_write(matrix, buf);
+  matrix_write_PSTR(matrix, "\nn:");
+  matrix_write_uint(matrix, stat->count, 0, ' ');
+
+  // min/mean/max
+  matrix_write_PSTR(matrix, "\n");
+  uint8_t *line = matrix->cursor;
+  matrix_write_PSTR(matrix, "us:");
+  matrix_write_uint(matrix, (uint32_t)stat->min * PROFILE_TICK_US, 0, ' ');
+  matrix_write_char(matrix, '/');
+  matrix_write_uint(matrix, stat->count ? stat->sum / stat->count * PROFILE_TICK_US : 0u, 0, ' ');
+  matrix_write_char(matrix, '/');
+  matrix_write_uint(matrix, (uint32_t)stat->max * PROFILE_TICK_US, 0, ' ');
+  matrix_clip_line(matrix, line);
+
+  // share of each log2 bucket, 0..9, the first one up to 32us
+  uint32_t hist_sum = 0u;
+  for ( uint8_t idx = 0; idx < PROFILE_HIST_NUM; idx++ ) {
+    hist_sum += stat->hist[idx];
   }
-  if (snprintf(buf, sizeof_buf, "%ld,", matrix_scan_run_time.max) > 0) {
-    matrix_write(matrix, buf);
+  matrix_write_PSTR(matrix, "\nlog2:");
+  for ( uint8_t idx = 0; idx < PROFILE_HIST_NUM; idx++ ) {
+    matrix_write_char(matrix, '0' + (hist_sum ? (uint32_t)stat->hist[idx] * 9u / hist_sum : 0u));
   }
 }
 #endif
 
+// Decimal of value, right aligned to width with pad ('0' or ' ') in front,
+// the 32 bit divisions stop as soon as the rest fits 16 bit.
+__attribute__ ((unused))
+static void
+matrix_write_uint(struct CharacterMatrix *matrix, uint32_t value, uint8_t width, char pad)
+{
+  char digits[10];
+  uint8_t num = 0;
+
+  for ( ; value > UINT16_MAX; value /= 10u ) {
+    digits[num++] = '0' + (value % 10u);
+  }
+  uint16_t value16 = value;
+  do {
+    digits[num++] = '0' + (value16 % 10u);
+    value16 /= 10u;
+  } while (value16 != 0u);
+
+  for ( ; width > num; width-- ) {
+    matrix_write_char(matrix, pad);
+  }
+  while (num > 0) {
+    matrix_write_char(matrix, digits[--num]);
+  }
+}
+
+// Cuts what the line from line wrote past its row, '>' marks the cut.
+// The last column stays free, as a '\n' there would add a blank row.
+// The rows below are still blank while render_status() writes from the top.
+__attribute__ ((unused))
+static void
+matrix_clip_line(struct CharacterMatrix *matrix, uint8_t *line)
+{
+  uint8_t *line_end = line + MatrixCols - 1;
+  if ( matrix->cursor <= line_end ) {
+    return;
+  }
+  memset(line_end, ' ', matrix->cursor - line_end);
+  line_end[-1] = '>';
+  matrix->cursor = line_end;
+}
+
+__attribute__ ((unused))
 static void
 matrix_update(struct CharacterMatrix *dest,
               const struct CharacterMatrix *source)
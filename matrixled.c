@@ -3,19 +3,33 @@
 #include QMK_KEYBOARD_H
 #include "rgblight.h"
 #include "matrixled.h"
+#include "eecache.h"
+#include "profiler.h"
+#include "trace.h"
 
 // configure
 #define DECAY_TIME              200 // ms
 #define MATLED_TASK_TIME        10  // ms
 #define TRACING_LEN             5   // cell
+#define PALETTE_BITS            6   // hue resolution of the palette, 3 bytes of RAM per entry, 5.6 deg steps
+
+// Fixed-point scheme, the engine is integer only (see `make -C bench float-check`)
+//   hue   : hue_bin, 8 bit binary angle, 256 = 360 deg
+//   value : 0 .. RGBLIGHT_LIMIT_VAL, as rgblight_config.val
+//   length: value units, `factor` per key cell, so a distance maps to a value directly
+//   rates : per MATLED_TASK_TIME tick, folded to integer constants at compile time,
+//           a refresh advances them by the elapsed ms (see tick_advance())
+//   Q8    : fraction in 1/256, scales a value by (x * q8) >> 8
+#define Q8_ONE              256u
+#define Q8_RATIO(num, den)  ((Q8_ONE * (num) + (den) / 2) / (den))
 
 #define MIN(a,b)            (((a) < (b)) ? (a) : (b))
 #define MAX(a,b)            (((a) > (b)) ? (a) : (b))
 #define SQUARE(x)           ((x) * (x))
 #define HUE_BIN_MAX         255
 #define HUE_BIN_QN          256
-#define HUE_BIN2DEG(x)      ((x) * (360.f/HUE_BIN_QN))
-#define HUE_DEG2BIN(x)      ((x) * (HUE_BIN_QN/360.f))
+#define HUE_BIN2DEG(x)      ((uint16_t)(x) * 360u / HUE_BIN_QN)
+#define HUE_DEG2BIN(x)      ((uint16_t)((x) * Q8_RATIO(HUE_BIN_QN, 360u) + Q8_ONE/2) >> 8)
 
 // External parameter from matrix.c
 extern uint8_t is_master;
@@ -52,6 +66,13 @@ enum LightingPattern {
   LP_NUM
 };
 
+// How matled_compose() composes the led_hv[] of a pattern into the frame,
+// in the same pass that sends it to rgblight_led[]
+enum LayerFlags {
+  LF_FULL_VALUE = 1u << 0,  // led_hv[].val is at RGBLIGHT_LIMIT_VAL, scaled to rgblight_config.val
+  LF_ON_BASE    = 1u << 1,  // added to the MATLED_BASE_VAL colour
+};
+
 struct {
   struct {
     uint8_t hue_bin;
@@ -60,15 +81,52 @@ struct {
   uint8_t hue_rnd;
   enum LightingPattern mode;
   bool is_refreshed;
+  bool is_draw_posted;
+  bool is_idle;
+  uint32_t idle_begin;
+  uint32_t idle_time;
 } matled_status;
 
-#define PRESSED_LIST_NUM      (8)
+// Full value colour of every hue_bin at palette.sat,
+// matled_compose() scales it by led_hv[].val instead of calling sethsv() per LED.
+#define PALETTE_NUM         (1 << PALETTE_BITS)
+#define HUE_BIN2PALETTE(x)  ((uint8_t)(x) >> (8 - PALETTE_BITS))
+static struct {
+  LED_TYPE rgb[PALETTE_NUM];
+  uint8_t sat;
+  bool is_valid;
+} palette;
+
+// Sources of RIPPLE and CROSS. The records in flight are linked from the
+// oldest to the newest through next, the others are on the free list, so
+// refreshes only walk live sources and both ends are O(1).
+#define PRESSED_LIST_NUM    MATLED_PRESSED_NUM
+#define PRESSED_NIL         UINT8_MAX
+_Static_assert(0 < PRESSED_LIST_NUM && PRESSED_LIST_NUM < PRESSED_NIL, "MATLED_PRESSED_NUM out of range");
 static struct PressedRecord {
   keypos_t key;
   uint8_t hue_bin;
+  uint8_t ring_begin;   // first ring_index[] entry not yet behind the wave
+  uint8_t next;         // pressed_list[] index, PRESSED_NIL at the end
+  uint8_t weight;       // presses coalesced into the source, scales its value
+  uint16_t time;        // timer_read() of the first press
+  uint8_t reach;        // distance to the farthest LED of this half the source lights
+  int far;              // wavefront of the frame on show, count before the last advance
   int count;
 } pressed_list[PRESSED_LIST_NUM];
-static uint8_t pressed_end = 0;
+static struct {
+  uint8_t head;         // oldest in flight
+  uint8_t tail;         // newest in flight
+  uint8_t free;
+  uint8_t num;          // in flight
+} pressed_queue;
+static struct MatledPressedCounts pressed_counts;
+
+// Bit per key of this half whose LED post_keypos_to_matled() lit, by row
+// from the top of the half. As the keys are lit when pressed, it is also the
+// matrix of the last refresh for them, so lit & ~matrix_get_row() are the
+// released ones and SWITCH and DIMLY only touch those.
+static matrix_row_t lit_keys[HELIX_ROWS];
 
 struct TaskTiming {
   uint16_t const EXCLUSIVE_TIME;
@@ -81,73 +139,112 @@ static struct TaskTiming refresh_task = {
   .EXCLUSIVE_TIME = MATLED_TASK_TIME,
 };
 
-static bool task_timing_check( struct TaskTiming* );
+static uint16_t task_timing_check( struct TaskTiming* );
+static uint16_t tick_advance(uint16_t *rem, uint16_t per_tick, uint16_t elapsed);
 
 static void update_color_random(void);
 
 static void post_keypos_to_matled(const keypos_t key_pos);
-static void post_keypos_to_queueing(const keypos_t key_pos);
-
+static void post_keypos_to_queueing(const keypos_t key_pos, uint8_t reach);
+static void pressed_queue_init(void);
+static struct PressedRecord *pressed_queue_push(void);
+static struct PressedRecord *pressed_queue_find_near(keypos_t keypos);
+static uint8_t pressed_queue_remove(uint8_t prev, uint8_t idx);
+static bool sources_advance(int advance, int tail);
+
+static void palette_update(void);
 static void matled_draw(void);
+static void matled_compose(void);
+static void matled_post_draw(void);
 static void matled_clear(void);
 static void matled_clear_led_hv(void);
+static void matled_add_led_hv(uint8_t led_idx, uint8_t hue_bin, uint16_t val);
+static void matled_enter_idle(void);
+static void matled_wake(void);
 static void matled_toggle(void);
 static void matled_mode_forward(void);
 static void matled_event_pressed(keyrecord_t *record);
 
 #ifdef ENABLE_MATLED_SWITCH_PATTERN
-static void matled_refresh_SWITCH(void);
+static bool matled_refresh_SWITCH(uint16_t elapsed);
 #endif
 #ifdef ENABLE_MATLED_DIMLY_PATTERN
-static void matled_refresh_DIMLY(void);
+static bool matled_refresh_DIMLY(uint16_t elapsed);
 #endif
 #ifdef ENABLE_MATLED_RIPPLE_PATTERN
-static void matled_refresh_RIPPLE(void);
+#define RIPPLE_FACTOR       (RGBLIGHT_LIMIT_VAL / TRACING_LEN)
+static void post_keypos_to_RIPPLE(const keypos_t key_pos);
+static bool matled_refresh_RIPPLE(uint16_t elapsed);
+static void matled_compose_RIPPLE(void);
 #endif
 #ifdef ENABLE_MATLED_CROSS_PATTERN
-static void matled_refresh_CROSS(void);
+#define CROSS_FACTOR        (RGBLIGHT_LIMIT_VAL / HELIX_COLS)
+static void post_keypos_to_CROSS(const keypos_t key_pos);
+static bool matled_refresh_CROSS(uint16_t elapsed);
+static void matled_compose_CROSS(void);
 #endif
 #ifdef ENABLE_MATLED_WAVE_PATTERN
-static void matled_refresh_WAVE(void);
-static void matled_refresh_WAVE_RB(void);
+#define WAVE_FACTOR         (RGBLIGHT_LIMIT_VAL / TRACING_LEN)
+#define WAVE_SLOPE          (-1)
+#define WAVE_PERIOD         (2 * RGBLIGHT_LIMIT_VAL)  // length units
+#define WAVE_RB_FACTOR      (128 / HELIX_COLS)
+static bool matled_refresh_WAVE(uint16_t elapsed);
+static bool matled_refresh_WAVE_RB(uint16_t elapsed);
 #endif
 
+// row offsets of the distance tables, a source on the other half is up to
+// 2 * HELIX_ROWS - 1 rows away
+#define CELL_DISTANCE_ROWS  (2 * HELIX_ROWS)
+
 static int get_ledidx_from_keypos( keypos_t keypos );
+static void led_geometry_init(void);
 static int distance(int x, int y);
+static uint8_t cell_distance(const uint8_t table[CELL_DISTANCE_ROWS][HELIX_COLS], int d_row, int d_col);
+static uint8_t cell_distance_reach(const uint8_t table[CELL_DISTANCE_ROWS][HELIX_COLS], keypos_t key, bool is_axis_only);
+static void ring_index_init(void);
+static uint8_t ring_distance(const uint8_t table[CELL_DISTANCE_ROWS][HELIX_COLS], uint8_t ring);
+static uint8_t ring_get_ledidx(keypos_t source, uint8_t ring, int ledidx[4]);
 static int distance_from_line(int x, int y, int m, int n);
 
 static const struct {
   void (*update_color)(void);
   void (*post_keypos)(keypos_t key_pos);
-  void (*matled_refresh)(void);
+  bool (*matled_refresh)(uint16_t elapsed);   // ms since the last refresh,
+                                              // returns false once there is nothing left to animate
+  void (*matled_compose)(void);               // the sources into led_hv[] at draw, NULL to draw led_hv[] as is
+  uint8_t layer;                              // enum LayerFlags
 } function_table[LP_NUM] = {
   [LP_STATIC]        = { 0 },
   #ifdef ENABLE_MATLED_SWITCH_PATTERN
-    [LP_SWITCH]     = { NULL,                post_keypos_to_matled,   matled_refresh_SWITCH },
-    [LP_SWITCH_RB]  = { update_color_random, post_keypos_to_matled,   matled_refresh_SWITCH },
+    [LP_SWITCH]     = { NULL,                post_keypos_to_matled,   matled_refresh_SWITCH,  NULL,                   LF_ON_BASE },
+    [LP_SWITCH_RB]  = { update_color_random, post_keypos_to_matled,   matled_refresh_SWITCH,  NULL,                   LF_ON_BASE },
   #endif
   #ifdef ENABLE_MATLED_DIMLY_PATTERN
-    [LP_DIMLY]      = { NULL,                post_keypos_to_matled,   matled_refresh_DIMLY },
-    [LP_DIMLY_RB]   = { update_color_random, post_keypos_to_matled,   matled_refresh_DIMLY },
+    [LP_DIMLY]      = { NULL,                post_keypos_to_matled,   matled_refresh_DIMLY,   NULL,                   LF_ON_BASE },
+    [LP_DIMLY_RB]   = { update_color_random, post_keypos_to_matled,   matled_refresh_DIMLY,   NULL,                   LF_ON_BASE },
   #endif
   #ifdef ENABLE_MATLED_RIPPLE_PATTERN
-    [LP_RIPPLE]     = { NULL,                post_keypos_to_queueing, matled_refresh_RIPPLE },
-    [LP_RIPPLE_RB]  = { update_color_random, post_keypos_to_queueing, matled_refresh_RIPPLE },
+    [LP_RIPPLE]     = { NULL,                post_keypos_to_RIPPLE,   matled_refresh_RIPPLE,  matled_compose_RIPPLE,  LF_FULL_VALUE | LF_ON_BASE },
+    [LP_RIPPLE_RB]  = { update_color_random, post_keypos_to_RIPPLE,   matled_refresh_RIPPLE,  matled_compose_RIPPLE,  LF_FULL_VALUE | LF_ON_BASE },
   #endif
   #ifdef ENABLE_MATLED_CROSS_PATTERN
-    [LP_CROSS]      = { NULL,                post_keypos_to_queueing, matled_refresh_CROSS },
-    [LP_CROSS_RB]   = { update_color_random, post_keypos_to_queueing, matled_refresh_CROSS },
+    [LP_CROSS]      = { NULL,                post_keypos_to_CROSS,    matled_refresh_CROSS,   matled_compose_CROSS,   LF_ON_BASE },
+    [LP_CROSS_RB]   = { update_color_random, post_keypos_to_CROSS,    matled_refresh_CROSS,   matled_compose_CROSS,   LF_ON_BASE },
   #endif
   #ifdef ENABLE_MATLED_WAVE_PATTERN
-    [LP_WAVE]       = { NULL,                NULL,                    matled_refresh_WAVE },
-    [LP_WAVE_RB]    = { NULL,                NULL,                    matled_refresh_WAVE_RB },
+    [LP_WAVE]       = { NULL,                NULL,                    matled_refresh_WAVE,    NULL,                   LF_FULL_VALUE },
+    [LP_WAVE_RB]    = { NULL,                NULL,                    matled_refresh_WAVE_RB, NULL,                   0 },
   #endif
 };
 
 void matled_init(void)
 {
+  led_geometry_init();
+  ring_index_init();
+
   rgblight_config.raw = eeconfig_read_rgblight();
   matled_status.mode = rgblight_config.mode;
+  memset(&pressed_counts, 0, sizeof(pressed_counts));
 
   matled_clear();
 }
@@ -157,23 +254,58 @@ int matled_get_mode(void)
   return matled_status.mode;
 }
 
+uint32_t matled_get_idle_time(void)
+{
+  uint32_t idle_time = matled_status.idle_time;
+  if (matled_status.is_idle) {
+    idle_time += timer_elapsed32(matled_status.idle_begin);
+  }
+  return idle_time;
+}
+
+const struct MatledPressedCounts *matled_get_pressed_counts(void)
+{
+  return &pressed_counts;
+}
+
 void matled_refresh_task(void)
 {
-  if ( !task_timing_check(&refresh_task) ) {
+  #ifdef MATLED_DEFERRED_DRAW
+    if (matled_status.is_draw_posted) {
+      matled_draw();
+      matled_status.is_draw_posted = matled_status.is_refreshed;
+    }
+  #endif
+
+  if (matled_status.is_idle) {
+    return;
+  }
+  // a stalled scan shows up as a longer elapsed time, not as a slower animation
+  uint16_t const elapsed = task_timing_check(&refresh_task);
+  if (elapsed == 0u) {
     return;
   }
 
+  bool is_active = false;
   uint8_t led_mode = matled_status.mode;
   if (led_mode >= LP_NUM) {
     // nothing mode
   }
   else {
     if ( function_table[led_mode].matled_refresh != NULL ) {
-      function_table[led_mode].matled_refresh();
+      PROFILE_BEGIN(MATLED_REFRESH);
+      is_active = function_table[led_mode].matled_refresh(elapsed);
+      PROFILE_END(MATLED_REFRESH);
+      TRACE(LED_REFRESH, (led_mode << 8) | is_active);
     }
   }
 
   matled_draw();
+
+  // sleep until the next key event once the last frame has been sent
+  if ( !is_active && !matled_status.is_refreshed ) {
+    matled_enter_idle();
+  }
 }
 
 #define PROCESS_OVERRIDE_BEHAVIOR   (false)
@@ -209,6 +341,8 @@ static void matled_toggle(void)
   else {
     rgblight_enable();
   }
+  TRACE(EEPROM, TRACE_EEPROM_RGBLIGHT);
+  eecache_sync_rgblight(rgblight_config.raw);
 
   matled_clear();
 }
@@ -218,7 +352,7 @@ static void matled_mode_forward(void)
 {
   matled_status.mode = (matled_status.mode + 1) % LP_NUM;
   rgblight_config.mode = matled_status.mode;
-  eeconfig_update_rgblight(rgblight_config.raw);
+  eecache_update_rgblight(rgblight_config.raw);   // written once the mode has settled
 
   matled_clear();
 }
@@ -243,7 +377,8 @@ static void matled_event_pressed(keyrecord_t *record)
     }
   }
 
-  matled_draw();
+  matled_wake();
+  matled_post_draw();
 }
 
 __attribute__ ((unused))
@@ -266,33 +401,150 @@ static void post_keypos_to_matled(keypos_t keypos)
     matled_status.led_hv[led_idx].hue_bin = hue_bin;
     matled_status.led_hv[led_idx].val = led_val;
     matled_status.is_refreshed = true;
+    if ( led_val > 0u ) {
+      lit_keys[keypos.row % HELIX_ROWS] |= (matrix_row_t)1u << keypos.col;
+    }
   }
 }
 
 __attribute__ ((unused))
-static void post_keypos_to_queueing(keypos_t keypos)
+static void post_keypos_to_queueing(keypos_t keypos, uint8_t reach)
 {
-    post_keypos_to_matled(keypos);
-
     uint8_t hue_bin = HUE_DEG2BIN(rgblight_config.hue) + matled_status.hue_rnd;
 
-    pressed_list[pressed_end].key = keypos;
-    pressed_list[pressed_end].hue_bin = hue_bin;
-    pressed_list[pressed_end].count = 1u;
-    pressed_end = (pressed_end + 1) % PRESSED_LIST_NUM;
+    // a rollover burst piles up ripples of nearly the same centre and age,
+    // draw them as one
+    struct PressedRecord *record = pressed_queue_find_near(keypos);
+    if ( record != NULL ) {
+      record->hue_bin = hue_bin;
+      record->weight = MIN(record->weight + 1, UINT8_MAX);
+      record->reach = MAX(record->reach, reach);
+      pressed_counts.coalesced++;
+      matled_status.is_refreshed = true;
+      return;
+    }
+
+    record = pressed_queue_push();
+    record->key = keypos;
+    record->hue_bin = hue_bin;
+    record->ring_begin = 0u;
+    record->weight = 1u;
+    record->time = timer_read();
+    record->reach = reach;
+    record->far = 1;
+    record->count = 1;
+    // the source lights its key in the next frame, the press frame
+    matled_status.is_refreshed = true;
+}
+
+__attribute__ ((unused))
+static void pressed_queue_init(void)
+{
+  for ( uint8_t idx = 0; idx < PRESSED_LIST_NUM; idx++ ) {
+    pressed_list[idx].next = idx + 1;
+  }
+  pressed_list[PRESSED_LIST_NUM - 1].next = PRESSED_NIL;
+  pressed_queue.head = PRESSED_NIL;
+  pressed_queue.tail = PRESSED_NIL;
+  pressed_queue.free = 0;
+  pressed_queue.num  = 0;
 }
 
+// a record at the newest end, the oldest one is reused when none is free
 __attribute__ ((unused))
-static bool task_timing_check( struct TaskTiming *task )
+static struct PressedRecord *pressed_queue_push(void)
+{
+  uint8_t idx = pressed_queue.free;
+  if ( idx != PRESSED_NIL ) {
+    pressed_queue.free = pressed_list[idx].next;
+    pressed_queue.num++;
+  }
+  else {
+    idx = pressed_queue.head;
+    pressed_queue.head = pressed_list[idx].next;
+    if ( pressed_queue.head == PRESSED_NIL ) {
+      pressed_queue.tail = PRESSED_NIL;
+    }
+    pressed_counts.evicted++;
+  }
+
+  pressed_list[idx].next = PRESSED_NIL;
+  if ( pressed_queue.tail == PRESSED_NIL ) {
+    pressed_queue.head = idx;
+  }
+  else {
+    pressed_list[pressed_queue.tail].next = idx;
+  }
+  pressed_queue.tail = idx;
+
+  pressed_counts.posted++;
+  pressed_counts.peak = MAX(pressed_counts.peak, pressed_queue.num);
+  return &pressed_list[idx];
+}
+
+// the newest source in flight within the coalescing windows of keypos, or NULL
+__attribute__ ((unused))
+static struct PressedRecord *pressed_queue_find_near(keypos_t keypos)
+{
+  struct PressedRecord *near = NULL;
+  if ( MATLED_COALESCE_TIME == 0 ) {
+    return near;
+  }
+  for ( uint8_t idx = pressed_queue.head; idx != PRESSED_NIL; idx = pressed_list[idx].next ) {
+    struct PressedRecord *it = &pressed_list[idx];
+    if ( (timer_elapsed(it->time) < MATLED_COALESCE_TIME)
+         && (abs(it->key.row - keypos.row) <= MATLED_COALESCE_CELLS)
+         && (abs(it->key.col - keypos.col) <= MATLED_COALESCE_CELLS) ) {
+      near = it;
+    }
+  }
+  return near;
+}
+
+// unlinks idx, which follows prev in flight (PRESSED_NIL for the head),
+// returns the record after it
+__attribute__ ((unused))
+static uint8_t pressed_queue_remove(uint8_t prev, uint8_t idx)
+{
+  uint8_t const next = pressed_list[idx].next;
+  if ( prev == PRESSED_NIL ) {
+    pressed_queue.head = next;
+  }
+  else {
+    pressed_list[prev].next = next;
+  }
+  if ( pressed_queue.tail == idx ) {
+    pressed_queue.tail = prev;
+  }
+
+  pressed_list[idx].next = pressed_queue.free;
+  pressed_queue.free = idx;
+  pressed_queue.num--;
+  return next;
+}
+
+// ms since the task last ran, 0 while that is less than EXCLUSIVE_TIME
+__attribute__ ((unused))
+static uint16_t task_timing_check( struct TaskTiming *task )
 {
   uint16_t current_time = timer_read();
   uint16_t diff_time = TIMER_DIFF_16(current_time, task->last_time);
   if ( diff_time < task->EXCLUSIVE_TIME ){
-    return false;
+    return 0u;
   }
 
   task->last_time = current_time;
-  return true;
+  return diff_time;
+}
+
+// per_tick * elapsed / MATLED_TASK_TIME, the remainder is kept in *rem for
+// the next call, so frames of any length add up to the nominal rate
+__attribute__ ((unused))
+static uint16_t tick_advance(uint16_t *rem, uint16_t per_tick, uint16_t elapsed)
+{
+  uint32_t const total = (uint32_t)per_tick * elapsed + *rem;
+  *rem = total % MATLED_TASK_TIME;
+  return total / MATLED_TASK_TIME;
 }
 
 __attribute__ ((unused))
@@ -305,32 +557,78 @@ static void matled_draw(void)
     return;
   }
 
-  for ( int idx = 0; idx < RGBLED_NUM; idx++ ) {
-    uint16_t led_hue = HUE_BIN2DEG(matled_status.led_hv[idx].hue_bin);
-    uint8_t led_sat  = rgblight_config.sat;
-    uint8_t led_val  = matled_status.led_hv[idx].val;
-    sethsv(led_hue, led_sat, led_val, &rgblight_led[idx]);
-  }
+  PROFILE_BEGIN(MATLED_DRAW);
+  palette_update();
+
+  matled_compose();
   matled_status.is_refreshed = false;
 
+  PROFILE_BEGIN(RGBLIGHT_SET);
   rgblight_set();
+  PROFILE_END(RGBLIGHT_SET);
+  TRACE(LED_FRAME, matled_status.mode);
+  PROFILE_END(MATLED_DRAW);
 }
 
+// same conversion as sethsv() at full value, redone only when the saturation changes
 __attribute__ ((unused))
-static void matled_clear(void)
+static void palette_update(void)
 {
-  for ( int idx = 0; idx < PRESSED_LIST_NUM; idx++ ) {
-    pressed_list[idx].count = 0u;
+  uint8_t const sat = rgblight_config.sat;
+  if ( palette.is_valid && (palette.sat == sat) ) {
+    return;
+  }
+
+  uint8_t const val  = 255u;
+  uint8_t const base = ((255u - sat) * val) >> 8;
+  for ( int idx = 0; idx < PALETTE_NUM; idx++ ) {
+    uint16_t hue   = HUE_BIN2DEG(idx << (8 - PALETTE_BITS));
+    uint8_t  color = (val - base) * (hue % 60u) / 60u;
+    uint8_t  r, g, b;
+    switch (hue / 60u) {
+      default:
+      case 0: r = val;          g = base + color; b = base;         break;
+      case 1: r = val - color;  g = val;          b = base;         break;
+      case 2: r = base;         g = val;          b = base + color; break;
+      case 3: r = base;         g = val - color;  b = val;          break;
+      case 4: r = base + color; g = base;         b = val;          break;
+      case 5: r = val;          g = base;         b = val - color;  break;
+    }
+    palette.rgb[idx].r = r;
+    palette.rgb[idx].g = g;
+    palette.rgb[idx].b = b;
   }
+  palette.sat = sat;
+  palette.is_valid = true;
+}
+
+// called on the key event path, keep rgblight_set() off it when deferred
+__attribute__ ((unused))
+static void matled_post_draw(void)
+{
+  #ifdef MATLED_DEFERRED_DRAW
+    matled_status.is_draw_posted = true;
+  #else
+    matled_draw();
+  #endif
+}
+
+__attribute__ ((unused))
+static void matled_clear(void)
+{
+  pressed_queue_init();
+
+  matled_wake();
 
   if (matled_status.mode == LP_STATIC) {
     rgblight_sethsv(rgblight_config.hue, rgblight_config.sat, rgblight_config.val);
+    matled_status.is_refreshed = false;
   }
   else {
     matled_status.hue_rnd = 0u;
     matled_clear_led_hv();
     matled_status.is_refreshed = true;
-    matled_draw();
+    matled_post_draw();
   }
 }
 
@@ -340,227 +638,483 @@ static void matled_clear_led_hv(void)
   for ( int idx = 0; idx < RGBLED_NUM; idx++ ) {
     matled_status.led_hv[idx].val = 0u;
   }
+  memset(lit_keys, 0, sizeof(lit_keys));
+}
+
+// a source's share of one LED, the newest source's hue where they overlap
+__attribute__ ((unused))
+static void matled_add_led_hv(uint8_t led_idx, uint8_t hue_bin, uint16_t val)
+{
+  uint16_t const sum = matled_status.led_hv[led_idx].val + val;
+  matled_status.led_hv[led_idx].hue_bin = hue_bin;
+  matled_status.led_hv[led_idx].val     = MIN(sum, RGBLIGHT_LIMIT_VAL);
 }
 
-#define FOREACH_MATRIX(row, col, LIMIT_ROW, LIMIT_COL)  \
-  int const row##_begin = is_master ? 0 : LIMIT_ROW;    \
-  int const row##_end   = row##_begin + LIMIT_ROW;      \
-  for ( int row = row##_begin; row < row##_end; row++ ) \
-  for ( int col = 0; col < LIMIT_COL; col++ )
+__attribute__ ((unused))
+static void matled_enter_idle(void)
+{
+  matled_status.is_idle = true;
+  matled_status.idle_begin = timer_read32();
+}
+
+__attribute__ ((unused))
+static void matled_wake(void)
+{
+  if (matled_status.is_idle) {
+    matled_status.is_idle = false;
+    matled_status.idle_time += timer_elapsed32(matled_status.idle_begin);
+    // refresh on the next scan, a single tick on from the idle frame
+    refresh_task.last_time = timer_read() - MATLED_TASK_TIME;
+  }
+}
+
+// distance() between key cells as a constant expression, indexed by |row|,|col| offset,
+// saturated at UINT8_MAX, which only the far corner of the other half reaches in RIPPLE
+#if HELIX_COLS != 7
+# error please update CELL_DISTANCE_ROW for HELIX_COLS
+#endif
+#define CELL_DISTANCE(factor, d_row, d_col) \
+  ((964L * MAX((factor) * (d_row), (factor) * (d_col)) + 420L * MIN((factor) * (d_row), (factor) * (d_col))) / 1024L)
+#define CELL_DISTANCE_U8(factor, d_row, d_col)  MIN(CELL_DISTANCE(factor, d_row, d_col), UINT8_MAX)
+#define CELL_DISTANCE_ROW(factor, d_row)  { \
+    CELL_DISTANCE_U8(factor, d_row, 0), CELL_DISTANCE_U8(factor, d_row, 1), CELL_DISTANCE_U8(factor, d_row, 2), \
+    CELL_DISTANCE_U8(factor, d_row, 3), CELL_DISTANCE_U8(factor, d_row, 4), CELL_DISTANCE_U8(factor, d_row, 5), \
+    CELL_DISTANCE_U8(factor, d_row, 6) }
+#if HELIX_ROWS == 5
+# define CELL_DISTANCE_TABLE(factor)  { \
+    CELL_DISTANCE_ROW(factor, 0), CELL_DISTANCE_ROW(factor, 1), CELL_DISTANCE_ROW(factor, 2), \
+    CELL_DISTANCE_ROW(factor, 3), CELL_DISTANCE_ROW(factor, 4), CELL_DISTANCE_ROW(factor, 5), \
+    CELL_DISTANCE_ROW(factor, 6), CELL_DISTANCE_ROW(factor, 7), CELL_DISTANCE_ROW(factor, 8), \
+    CELL_DISTANCE_ROW(factor, 9) }
+#else
+# define CELL_DISTANCE_TABLE(factor)  { \
+    CELL_DISTANCE_ROW(factor, 0), CELL_DISTANCE_ROW(factor, 1), CELL_DISTANCE_ROW(factor, 2), \
+    CELL_DISTANCE_ROW(factor, 3), CELL_DISTANCE_ROW(factor, 4), CELL_DISTANCE_ROW(factor, 5), \
+    CELL_DISTANCE_ROW(factor, 6), CELL_DISTANCE_ROW(factor, 7) }
+#endif
+
+// Cell offsets (|d_row|, |d_col|) sorted by distance, built by ring_index_init().
+// Scaling keeps the order, so one index serves every distance table,
+// and each entry stands for the up to four keys at that offset from a source.
+#define RING_NUM            (CELL_DISTANCE_ROWS * HELIX_COLS)
+#define RING_CELL(d_row, d_col)   (((d_row) << 4) | (d_col))
+#define RING_ROW(cell)      ((cell) >> 4)
+#define RING_COL(cell)      ((cell) & 0x0F)
+static uint8_t ring_index[RING_NUM];
+
+// Underglow LED under each key of one half, func(led_idx, row, col),
+// row and col as in the master's matrix, the slave's rows follow HELIX_ROWS later.
+#if HELIX_ROWS == 5
+# define APPLY_LED_LAYOUT(func) \
+    func( 5, 0, 0) func( 4, 0, 1) func( 3, 0, 2) func( 2, 0, 3) func( 1, 0, 4) func( 0, 0, 5)                \
+    func( 6, 1, 0) func( 7, 1, 1) func( 8, 1, 2) func( 9, 1, 3) func(10, 1, 4) func(11, 1, 5)                \
+    func(17, 2, 0) func(16, 2, 1) func(15, 2, 2) func(14, 2, 3) func(13, 2, 4) func(12, 2, 5)                \
+    func(18, 3, 0) func(19, 3, 1) func(20, 3, 2) func(21, 3, 3) func(22, 3, 4) func(23, 3, 5) func(24, 3, 6) \
+    func(31, 4, 0) func(30, 4, 1) func(29, 4, 2) func(28, 4, 3) func(27, 4, 4) func(26, 4, 5) func(25, 4, 6)
+#else
+# error please write APPLY_LED_LAYOUT for HELIX_ROWS
+#endif
+#define LED_LAYOUT_COUNT(led_idx, row, col)     + 1
+#define LED_LAYOUT_KEYPOS(led_idx, row, col)    [row][col] = (led_idx) + 1,
+#define LED_GEOMETRY_NUM    (0 APPLY_LED_LAYOUT(LED_LAYOUT_COUNT))
+_Static_assert(LED_GEOMETRY_NUM == RGBLED_NUM, "matled_compose() only draws the LEDs under the keys of APPLY_LED_LAYOUT");
+
+// led_idx + 1 of every key on a half, 0 for keys without a LED
+static const uint8_t PROGMEM keypos2ledidx[HELIX_ROWS][HELIX_COLS] = {
+  APPLY_LED_LAYOUT(LED_LAYOUT_KEYPOS)
+};
+
+// The LEDs of this half in matrix order, built by led_geometry_init().
+//   row: matrix row, already offset on the slave
+//   wave_phase: WAVE phase of the key, 256 per WAVE_PERIOD
+//   wave_hue: WAVE_RB hue_bin of the key
+static struct LedGeometry {
+  uint8_t led_idx;
+  uint8_t row;
+  uint8_t col;
+#ifdef ENABLE_MATLED_WAVE_PATTERN
+  uint8_t wave_phase;
+  uint8_t wave_hue;
+#endif
+} led_geometry[LED_GEOMETRY_NUM];
+
+#define FOREACH_LED_GEOMETRY(it)  \
+  for ( const struct LedGeometry *it = &led_geometry[0]; it < &led_geometry[LED_GEOMETRY_NUM]; it++ )
+
+#if defined(ENABLE_MATLED_SWITCH_PATTERN) || defined(ENABLE_MATLED_DIMLY_PATTERN)
+// led_idx of the key at bit col of lit_keys[row]
+static inline uint8_t lit_key_ledidx(uint8_t row, uint8_t col)
+{
+  return pgm_read_byte(&keypos2ledidx[row][col]) - 1;
+}
+#endif
 
 #ifdef ENABLE_MATLED_SWITCH_PATTERN
-static void matled_refresh_SWITCH(void)
+static bool matled_refresh_SWITCH(uint16_t elapsed)
 {
-  FOREACH_MATRIX(row, col, HELIX_ROWS, HELIX_COLS) {
-    int led_idx = get_ledidx_from_keypos( (keypos_t){.row = row, .col = col} );
-    if ( led_idx >= 0 && !matrix_is_on( row, col ) ) {
-      matled_status.led_hv[led_idx].hue_bin = 0u;
-      matled_status.led_hv[led_idx].val = 0u;
-      matled_status.is_refreshed = true;
+  uint8_t const row_begin = is_master ? 0 : HELIX_ROWS;
+  bool is_lit = false;
+
+  for ( uint8_t row = 0; row < HELIX_ROWS; row++ ) {
+    matrix_row_t released = lit_keys[row] & ~matrix_get_row(row_begin + row);
+    lit_keys[row] &= ~released;
+    is_lit |= (lit_keys[row] != 0u);
+
+    for ( uint8_t col = 0; released != 0u; col++, released >>= 1 ) {
+      if ( released & 1u ) {
+        uint8_t const led_idx = lit_key_ledidx(row, col);
+        matled_status.led_hv[led_idx].hue_bin = 0u;
+        matled_status.led_hv[led_idx].val = 0u;
+        matled_status.is_refreshed = true;
+      }
     }
   }
+
+  return is_lit;
 }
 #endif // ENABLE_MATLED_SWITCH_PATTERN
 
 #ifdef ENABLE_MATLED_DIMLY_PATTERN
-static void matled_refresh_DIMLY(void)
+static bool matled_refresh_DIMLY(uint16_t elapsed)
 {
-  int led_decay_val = rgblight_config.val * (1.f * MATLED_TASK_TIME / DECAY_TIME);
-
-  FOREACH_MATRIX(row, col, HELIX_ROWS, HELIX_COLS) {
-    int led_idx = get_ledidx_from_keypos( (keypos_t){.row = row, .col = col} );
-    if ( led_idx >= 0 && !matrix_is_on( row, col ) ) {
-      matled_status.led_hv[led_idx].val = MAX(0, matled_status.led_hv[led_idx].val - led_decay_val);
-      matled_status.is_refreshed = true;
+  static const uint8_t decay_q8 = Q8_RATIO(MATLED_TASK_TIME, DECAY_TIME);
+  static uint16_t decay_rem;
+  int led_decay_val = tick_advance(&decay_rem, MAX(1, (rgblight_config.val * decay_q8) >> 8), elapsed);
+
+  uint8_t const row_begin = is_master ? 0 : HELIX_ROWS;
+  bool is_lit = false;
+
+  for ( uint8_t row = 0; row < HELIX_ROWS; row++ ) {
+    matrix_row_t released = lit_keys[row] & ~matrix_get_row(row_begin + row);
+
+    for ( uint8_t col = 0; released != 0u; col++, released >>= 1 ) {
+      if ( released & 1u ) {
+        uint8_t const led_idx = lit_key_ledidx(row, col);
+        matled_status.led_hv[led_idx].val = MAX(0, matled_status.led_hv[led_idx].val - led_decay_val);
+        matled_status.is_refreshed = true;
+        if ( matled_status.led_hv[led_idx].val == 0u ) {
+          lit_keys[row] &= ~((matrix_row_t)1u << col);
+        }
+      }
     }
+    is_lit |= (lit_keys[row] != 0u);
   }
+
+  return is_lit;
 }
 #endif
 
 #ifdef ENABLE_MATLED_RIPPLE_PATTERN
-static void matled_refresh_RIPPLE(void)
+// Ripple shape, the value of a key u length units behind the outline of a
+// ripple: a ramp up over the RIPPLE_LEAD in front of the wavefront, then a
+// fade over the RIPPLE_TAIL behind it, the same at every age.
+// Only evaluated at compile time for ripple_profile[], edit it to reshape
+// the ripple.
+#define RIPPLE_LEAD         (RIPPLE_FACTOR * 1)
+#define RIPPLE_TAIL         (RIPPLE_FACTOR * TRACING_LEN)
+#define RIPPLE_PROFILE(u) \
+  ( ((u) < RIPPLE_LEAD) ? RGBLIGHT_LIMIT_VAL * (u) / RIPPLE_LEAD \
+  : ((u) < RIPPLE_LEAD + RIPPLE_TAIL) ? RGBLIGHT_LIMIT_VAL * (RIPPLE_LEAD + RIPPLE_TAIL - (u)) / RIPPLE_TAIL \
+  : 0 )
+
+// ripple_profile[u bucket], at the middle of each bucket
+#define RIPPLE_PROFILE_SHIFT  2   // u bucket, 4 length units
+#define RIPPLE_PROFILE_NUM    40
+_Static_assert(((RIPPLE_LEAD + RIPPLE_TAIL) >> RIPPLE_PROFILE_SHIFT) < RIPPLE_PROFILE_NUM,
+               "ripple_profile[] is shorter than the ripple");
+#define RIPPLE_PROFILE_AT(u) \
+  RIPPLE_PROFILE(((u) << RIPPLE_PROFILE_SHIFT) + (1 << RIPPLE_PROFILE_SHIFT) / 2)
+#define RIPPLE_PROFILE_AT8(u) \
+    RIPPLE_PROFILE_AT((u) + 0), RIPPLE_PROFILE_AT((u) + 1), RIPPLE_PROFILE_AT((u) + 2), \
+    RIPPLE_PROFILE_AT((u) + 3), RIPPLE_PROFILE_AT((u) + 4), RIPPLE_PROFILE_AT((u) + 5), \
+    RIPPLE_PROFILE_AT((u) + 6), RIPPLE_PROFILE_AT((u) + 7)
+#if RIPPLE_PROFILE_NUM != 40
+# error please update ripple_profile[] for the bucket number
+#endif
+static const uint8_t PROGMEM ripple_profile[RIPPLE_PROFILE_NUM] = {
+  RIPPLE_PROFILE_AT8(0),  RIPPLE_PROFILE_AT8(8),  RIPPLE_PROFILE_AT8(16),
+  RIPPLE_PROFILE_AT8(24), RIPPLE_PROFILE_AT8(32)
+};
+
+static const uint8_t PROGMEM ripple_distance_table[CELL_DISTANCE_ROWS][HELIX_COLS] = CELL_DISTANCE_TABLE(RIPPLE_FACTOR);
+
+static bool matled_refresh_RIPPLE(uint16_t elapsed)
+{
+  static const int count_step   = RIPPLE_FACTOR * TRACING_LEN * MATLED_TASK_TIME / DECAY_TIME;
+  static uint16_t count_rem;
+
+  return sources_advance(tick_advance(&count_rem, count_step, elapsed), RIPPLE_TAIL);
+}
+
+static void post_keypos_to_RIPPLE(keypos_t keypos)
+{
+  post_keypos_to_queueing(keypos, cell_distance_reach(ripple_distance_table, keypos, false));
+}
+// Each source from the oldest to the newest, over its rings in [near, outline] only
+static void matled_compose_RIPPLE(void)
 {
-  static const int factor_numer = RGBLIGHT_LIMIT_VAL;
-  static const int factor_denom = TRACING_LEN;
-  static const int factor       = factor_numer / factor_denom;
-  static const int count_step   = factor * TRACING_LEN / (1.f * DECAY_TIME / MATLED_TASK_TIME);
-  static const int near_max     = factor * (HELIX_ROWS + HELIX_COLS);
+  matled_clear_led_hv();
 
-  int const idx_end = pressed_end;
-  int idx = (idx_end + 1) % PRESSED_LIST_NUM;
-  for ( ; idx != idx_end; idx = (idx + 1) % PRESSED_LIST_NUM ) {
+  for ( uint8_t idx = pressed_queue.head; idx != PRESSED_NIL; idx = pressed_list[idx].next ) {
     struct PressedRecord* it_source_pos = &pressed_list[idx];
-    if ( it_source_pos->count <= 0u ) {
-      continue;
-    }
-    else if (!matled_status.is_refreshed) {
-      matled_clear_led_hv();
-      matled_status.is_refreshed = true;
-    }
+    int const near    = MAX(0, it_source_pos->far - RIPPLE_TAIL);
+    int const outline = it_source_pos->far + RIPPLE_LEAD;
 
-    int far = it_source_pos->count;
-    int near = MAX(0, far - (factor*TRACING_LEN));
-    if (near >= near_max) {
-      it_source_pos->count = 0u;
-      continue;
+    // rings only grow, skip the ones the wave has left for good
+    while ( (it_source_pos->ring_begin < RING_NUM)
+            && (ring_distance(ripple_distance_table, it_source_pos->ring_begin) < near) ) {
+      it_source_pos->ring_begin++;
     }
-    int outline = far + factor*1;
 
-    FOREACH_MATRIX(row, col, HELIX_ROWS, HELIX_COLS) {
-      int led_idx = get_ledidx_from_keypos( (keypos_t){.col=col, .row=row} );
-      if (led_idx < 0) {
-        continue;
+    for ( uint8_t ring = it_source_pos->ring_begin; ring < RING_NUM; ring++ ) {
+      int const d = ring_distance(ripple_distance_table, ring);
+      if (outline < d) {
+        break;
       }
+      uint16_t const val = pgm_read_byte(&ripple_profile[(outline - d) >> RIPPLE_PROFILE_SHIFT]) * it_source_pos->weight;
 
-      // led_val = (LIMIT_VAL / LIMIT_CELL) * cell_num;
-      int x = factor * (it_source_pos->key.col - col);
-      int y = factor * (it_source_pos->key.row - row);
-      int d = distance(x, y);
-      if ((d < near) || (outline < d)) {
-        continue;
-      }
-      else if (d > far) {
-        // led_val' = (LIMIT_VAL / 1) * cell_num
-        //          = (LIMIT_VAL / LIMIT_CELL) * cell_num * LIMIT_CELL
-        //          = led_val * LIMIT_CELL
-        d = (far - d) * factor_denom + far;
+      int ledidx[4];
+      uint8_t const ledidx_num = ring_get_ledidx(it_source_pos->key, ring, ledidx);
+      for ( uint8_t it = 0; it < ledidx_num; it++ ) {
+        matled_add_led_hv(ledidx[it], it_source_pos->hue_bin, val);
       }
-
-      int val = rgblight_config.val - (far - d);
-      matled_status.led_hv[led_idx].hue_bin = it_source_pos->hue_bin;
-      matled_status.led_hv[led_idx].val     = MIN(matled_status.led_hv[led_idx].val + val, RGBLIGHT_LIMIT_VAL);
     }
-    it_source_pos->count += count_step;
   }
 }
 #endif // ENABLE_MATLED_RIPPLE_PATTERN
 
 #ifdef ENABLE_MATLED_CROSS_PATTERN
-static void matled_refresh_CROSS(void)
-{
-  static const int factor = RGBLIGHT_LIMIT_VAL / HELIX_COLS;
-  static const int count_step = factor * TRACING_LEN / (1.f * DECAY_TIME / MATLED_TASK_TIME);
-  static const int near_max = factor * (HELIX_ROWS + HELIX_COLS);
+#define CROSS_TAIL          (CROSS_FACTOR * TRACING_LEN)
+static const uint8_t PROGMEM cross_distance_table[CELL_DISTANCE_ROWS][HELIX_COLS] = CELL_DISTANCE_TABLE(CROSS_FACTOR);
 
-  int const idx_end = pressed_end;
-  int idx = (idx_end + 1) % PRESSED_LIST_NUM;
-  for ( ; idx != idx_end; idx = (idx + 1) % PRESSED_LIST_NUM ) {
-    struct PressedRecord* it_source_pos = &pressed_list[idx];
-    if ( it_source_pos->count <= 0u ) {
-      continue;
-    }
-    else if (!matled_status.is_refreshed) {
-      matled_clear_led_hv();
-      matled_status.is_refreshed = true;
-    }
+static bool matled_refresh_CROSS(uint16_t elapsed)
+{
+  static const int count_step = CROSS_TAIL * MATLED_TASK_TIME / DECAY_TIME;
+  static uint16_t count_rem;
 
-    int far = it_source_pos->count;
-    int near = MAX(0, far - (factor*TRACING_LEN));
-    if (near >= near_max) {
-      it_source_pos->count = 0u;
-      continue;
-    }
+  return sources_advance(tick_advance(&count_rem, count_step, elapsed), CROSS_TAIL);
+}
 
-    FOREACH_MATRIX(row, col, HELIX_ROWS, HELIX_COLS) {
-      if ( (it_source_pos->key.row != row) && (it_source_pos->key.col != col) ) {
-        continue;
+static void post_keypos_to_CROSS(keypos_t keypos)
+{
+  post_keypos_to_queueing(keypos, cell_distance_reach(cross_distance_table, keypos, true));
+}
+// Each source from the oldest to the newest, over its row and column on this half
+static void matled_compose_CROSS(void)
+{
+  matled_clear_led_hv();
+
+  int const row_begin = is_master ? 0 : HELIX_ROWS;
+  for ( uint8_t idx = pressed_queue.head; idx != PRESSED_NIL; idx = pressed_list[idx].next ) {
+    const struct PressedRecord* it_source_pos = &pressed_list[idx];
+    int const far  = it_source_pos->far;
+    int const near = MAX(0, far - CROSS_TAIL);
+
+    // the row, if the source is on this half, then the column without the source itself
+    keypos_t const source = it_source_pos->key;
+    bool const is_row_here = (row_begin <= source.row) && (source.row < row_begin + HELIX_ROWS);
+    for ( int it = (is_row_here ? 0 : HELIX_COLS); it < HELIX_COLS + HELIX_ROWS; it++ ) {
+      keypos_t key = source;
+      if ( it < HELIX_COLS ) {
+        key.col = it;
       }
-
-      int led_idx = get_ledidx_from_keypos( (keypos_t){.col=col, .row=row} );
-      if (led_idx < 0) {
+      else if ( row_begin + (it - HELIX_COLS) == source.row ) {
         continue;
       }
+      else {
+        key.row = row_begin + (it - HELIX_COLS);
+      }
 
-      int x = factor * (it_source_pos->key.col - col);
-      int y = factor * (it_source_pos->key.row - row);
-      int d = distance(x, y);
+      int const d = cell_distance(cross_distance_table, source.row - key.row, source.col - key.col);
       if ((d < near) || (far < d)) {
         continue;
       }
-
-      int val = rgblight_config.val - (far - d);
-      matled_status.led_hv[led_idx].hue_bin = it_source_pos->hue_bin;
-      matled_status.led_hv[led_idx].val     = MIN(matled_status.led_hv[led_idx].val + val, RGBLIGHT_LIMIT_VAL);
+      int const led_idx = get_ledidx_from_keypos(key);
+      if (led_idx < 0) {
+        continue;
+      }
+      matled_add_led_hv(led_idx, it_source_pos->hue_bin, MAX(0, rgblight_config.val - (far - d)) * it_source_pos->weight);
     }
-    it_source_pos->count += count_step;
   }
 }
 #endif // ENABLE_MATLED_CROSS_PATTERN
 
-#ifdef ENABLE_MATLED_WAVE_PATTERN
-static void matled_refresh_WAVE(void)
+// moves the sources on to their next frame, and drops the ones whose tail
+// has passed the farthest LED they light on this half
+__attribute__ ((unused))
+static bool sources_advance(int advance, int tail)
 {
-  static const int factor = RGBLIGHT_LIMIT_VAL / TRACING_LEN;
-  static const int slope = -1;
-  static const int ofst_step = 256 * (MATLED_TASK_TIME / 1000.f);
-  static uint16_t ofst;
-
-  ofst += ofst_step;
+  bool is_active = false;
+  if ( pressed_queue.head != PRESSED_NIL ) {
+    // the frame changes, if only to drop the last source
+    matled_status.is_refreshed = true;
+  }
 
-  FOREACH_MATRIX(row, col, HELIX_ROWS, HELIX_COLS) {
-    int led_idx = get_ledidx_from_keypos( (keypos_t){.col=col, .row=row} );
-    if (led_idx < 0) {
+  uint8_t prev = PRESSED_NIL;
+  for ( uint8_t idx = pressed_queue.head; idx != PRESSED_NIL; ) {
+    struct PressedRecord* it_source_pos = &pressed_list[idx];
+    if ( it_source_pos->count - tail > it_source_pos->reach ) {
+      idx = pressed_queue_remove(prev, idx);
       continue;
     }
+    it_source_pos->far = it_source_pos->count;
+    it_source_pos->count += advance;
+    is_active = true;
+    prev = idx;
+    idx = it_source_pos->next;
+  }
+
+  return is_active;
+}
 
-    int x = factor * col;
-    int y = factor * row;
-    unsigned int d     = distance_from_line(x, y, slope, ofst);
-    unsigned int d_mod = d % RGBLIGHT_LIMIT_VAL;
-    int value = (d / RGBLIGHT_LIMIT_VAL) & 1
-                  ? d_mod
-                  : rgblight_config.val - d_mod;
-    matled_status.led_hv[led_idx].hue_bin = HUE_DEG2BIN(rgblight_config.hue);
-    matled_status.led_hv[led_idx].val     = MAX(0, value);
+// The pattern's sources, if any, added into led_hv[] band by band, then one
+// pass over the LEDs: scaled for LF_FULL_VALUE, added to the base colour,
+// and written to rgblight_led[]
+__attribute__ ((unused))
+static void matled_compose(void)
+{
+  if ( matled_status.mode >= LP_NUM ) {
+    return;
+  }
+  if ( function_table[matled_status.mode].matled_compose != NULL ) {
+    function_table[matled_status.mode].matled_compose();
+  }
+
+  uint8_t const layer = function_table[matled_status.mode].layer;
+  uint16_t const layer_q8 = ( (layer & LF_FULL_VALUE) && (rgblight_config.val < RGBLIGHT_LIMIT_VAL) )
+                              ? (rgblight_config.val * Q8_ONE) / RGBLIGHT_LIMIT_VAL
+                              : Q8_ONE;
+#ifdef MATLED_BASE_VAL
+  LED_TYPE base = { 0 };
+  if (layer & LF_ON_BASE) {
+    const LED_TYPE *color = &palette.rgb[HUE_BIN2PALETTE(HUE_DEG2BIN(rgblight_config.hue))];
+    uint16_t const scale = MIN(MATLED_BASE_VAL, rgblight_config.val) + 1u;
+    base.r = (color->r * scale) >> 8;
+    base.g = (color->g * scale) >> 8;
+    base.b = (color->b * scale) >> 8;
+  }
+#endif
+
+  FOREACH_LED_GEOMETRY(it) {
+    uint8_t const idx = it->led_idx;
+    uint8_t const hue_bin = matled_status.led_hv[idx].hue_bin;
+    // rgblight_config.val may be above the limit, sethsv() clamped it
+    uint8_t const val     = MIN(matled_status.led_hv[idx].val, RGBLIGHT_LIMIT_VAL);
+
+    const LED_TYPE *color = &palette.rgb[HUE_BIN2PALETTE(hue_bin)];
+    uint16_t scale = ((val * layer_q8) >> 8) + 1u;
+#ifdef MATLED_BASE_VAL
+    rgblight_led[idx].r = MIN(base.r + ((color->r * scale) >> 8), 255u);
+    rgblight_led[idx].g = MIN(base.g + ((color->g * scale) >> 8), 255u);
+    rgblight_led[idx].b = MIN(base.b + ((color->b * scale) >> 8), 255u);
+#else
+    rgblight_led[idx].r = (color->r * scale) >> 8;
+    rgblight_led[idx].g = (color->g * scale) >> 8;
+    rgblight_led[idx].b = (color->b * scale) >> 8;
+#endif
   }
-  matled_status.is_refreshed = true;
 }
 
-static void matled_refresh_WAVE_RB(void)
+#ifdef ENABLE_MATLED_WAVE_PATTERN
+// wave_triangle[t]: WAVE value at phase t of the first half period, full at 0,
+// 0 at 128, the second half is the first one mirrored
+#define WAVE_TRIANGLE(t)    (RGBLIGHT_LIMIT_VAL * (128 - (t)) / 128)
+#define WAVE_TRIANGLE8(t) \
+    WAVE_TRIANGLE((t) + 0), WAVE_TRIANGLE((t) + 1), WAVE_TRIANGLE((t) + 2), WAVE_TRIANGLE((t) + 3), \
+    WAVE_TRIANGLE((t) + 4), WAVE_TRIANGLE((t) + 5), WAVE_TRIANGLE((t) + 6), WAVE_TRIANGLE((t) + 7)
+static const uint8_t PROGMEM wave_triangle[128] = {
+  WAVE_TRIANGLE8(0),   WAVE_TRIANGLE8(8),   WAVE_TRIANGLE8(16),  WAVE_TRIANGLE8(24),
+  WAVE_TRIANGLE8(32),  WAVE_TRIANGLE8(40),  WAVE_TRIANGLE8(48),  WAVE_TRIANGLE8(56),
+  WAVE_TRIANGLE8(64),  WAVE_TRIANGLE8(72),  WAVE_TRIANGLE8(80),  WAVE_TRIANGLE8(88),
+  WAVE_TRIANGLE8(96),  WAVE_TRIANGLE8(104), WAVE_TRIANGLE8(112), WAVE_TRIANGLE8(120),
+};
+
+// phase and hue of a key relative to the wave, once at init
+__attribute__ ((unused))
+static void wave_geometry_init(struct LedGeometry *it)
 {
-  static uint16_t count;
-  static const uint16_t count_step = 256 * (MATLED_TASK_TIME / 1000.f);
-  static const uint8_t factor = 128 / HELIX_COLS;
+  int const x = WAVE_FACTOR * it->col;
+  int const y = WAVE_FACTOR * it->row;
+  long const d = distance_from_line(x, y, WAVE_SLOPE, 0);
+  it->wave_phase = -((d * 256 + WAVE_PERIOD / 2) / WAVE_PERIOD);
+  it->wave_hue   = WAVE_RB_FACTOR * (it->row + it->col);
+}
 
-  FOREACH_MATRIX(row, col, HELIX_ROWS, HELIX_COLS) {
-    int led_idx = get_ledidx_from_keypos( (keypos_t){.col=col, .row=row} );
-    if (led_idx < 0) {
-      continue;
-    }
+static bool matled_refresh_WAVE(uint16_t elapsed)
+{
+  // 1/256 of WAVE_PERIOD with 8 bits of fraction, moving 256 * MATLED_TASK_TIME / 1000
+  // length units per tick
+  static const uint16_t phase_step = ((256u * MATLED_TASK_TIME / 1000u) * 65536UL + WAVE_PERIOD / 2) / WAVE_PERIOD;
+  static uint16_t phase, phase_rem;
+
+  phase += tick_advance(&phase_rem, phase_step, elapsed);
+
+  uint8_t const phase_now = phase >> 8;
+  uint8_t const hue_bin   = HUE_DEG2BIN(rgblight_config.hue);
+  FOREACH_LED_GEOMETRY(it) {
+    uint8_t const led_idx = it->led_idx;
+    uint8_t const t       = phase_now + it->wave_phase;
+    matled_status.led_hv[led_idx].hue_bin = hue_bin;
+    matled_status.led_hv[led_idx].val     = pgm_read_byte(&wave_triangle[(t & 0x80u) ? (uint8_t)~t : t]);
+  }
+  matled_status.is_refreshed = true;
+
+  return true;
+}
 
-    matled_status.led_hv[led_idx].hue_bin = factor * (row + col) + count;
+static bool matled_refresh_WAVE_RB(uint16_t elapsed)
+{
+  static uint8_t count;
+  static uint16_t count_rem;
+  static const uint16_t count_step = 256 * MATLED_TASK_TIME / 1000;
+
+  FOREACH_LED_GEOMETRY(it) {
+    uint8_t const led_idx = it->led_idx;
+    matled_status.led_hv[led_idx].hue_bin = it->wave_hue + count;
     matled_status.led_hv[led_idx].val     = rgblight_config.val;
   }
   matled_status.is_refreshed = true;
 
-  count -= count_step;
+  count -= tick_advance(&count_rem, count_step, elapsed);
+
+  return true;
 }
 #endif // ENABLE_MATLED_WAVE_PATTERN
 
 static int get_ledidx_from_keypos( keypos_t keypos )
 {
-  static const uint8_t PROGMEM keypos2ledidx_lut[MATRIX_ROWS][MATRIX_COLS] = LAYOUT( \
-       5,  4,  3,  2,  1, 32,         32,  1,  2,  3,  4,  5, \
-       6,  7,  8,  9, 10, 11,         11, 10,  9,  8,  7,  6, \
-      17, 16, 15, 14, 13, 12,         12, 13, 14, 15, 16, 17, \
-      18, 19, 20, 21, 22, 23, 24, 24, 23, 22, 21, 20, 19, 18, \
-      31, 30, 29, 28, 27, 26, 25, 25, 26, 27, 28, 29, 30, 31  \
-  );
-  bool keypos_is_valid;
-  if ( is_master ) {
-    keypos_is_valid = (keypos.row < HELIX_ROWS) && (keypos.col < HELIX_COLS);
-  }
-  else {
-    keypos_is_valid = (HELIX_ROWS <= keypos.row) && (keypos.row < MATRIX_ROWS)
-                                                 && (keypos.col < MATRIX_COLS);
-  }
-  if ( !keypos_is_valid ) {
+  // keys of the other half wrap around to HELIX_ROWS or more
+  uint8_t const row = keypos.row - (is_master ? 0 : HELIX_ROWS);
+  if ( (row >= HELIX_ROWS) || (keypos.col >= HELIX_COLS) ) {
     return -1;
   }
   else {
-    int idx = pgm_read_byte(&keypos2ledidx_lut[keypos.row][keypos.col]);
-    int idx_mod32 = idx & 31;
-    return ( idx > 0 ) ? ( idx_mod32 ) : ( -1 );
+    return (int)pgm_read_byte(&keypos2ledidx[row][keypos.col]) - 1;
+  }
+}
+
+// the LEDs of keypos2ledidx[] on this half, once at init as is_master is known by then
+__attribute__ ((unused))
+static void led_geometry_init(void)
+{
+  uint8_t const row_begin = is_master ? 0 : HELIX_ROWS;
+  uint8_t num = 0;
+
+  for ( uint8_t row = 0; row < HELIX_ROWS; row++ ) {
+    for ( uint8_t col = 0; col < HELIX_COLS; col++ ) {
+      uint8_t const led_idx1 = pgm_read_byte(&keypos2ledidx[row][col]);
+      if ( led_idx1 == 0u ) {
+        continue;
+      }
+      led_geometry[num++] = (struct LedGeometry){
+        .led_idx = led_idx1 - 1,
+        .row     = row_begin + row,
+        .col     = col,
+      };
+#ifdef ENABLE_MATLED_WAVE_PATTERN
+      wave_geometry_init(&led_geometry[num - 1]);
+#endif
+    }
   }
 }
 
@@ -587,6 +1141,114 @@ static int distance(int x, int y)
 #endif
 }
 
+__attribute__ ((unused))
+static uint8_t cell_distance(const uint8_t table[CELL_DISTANCE_ROWS][HELIX_COLS], int d_row, int d_col)
+{
+  return pgm_read_byte(&table[abs(d_row)][abs(d_col)]);
+}
+
+// distance from key to the farthest LED of this half, or only of its row
+// and column for is_axis_only, 0 when there is none. The distance grows with
+// |d_row| and |d_col|, so only the ends of each row need a look.
+__attribute__ ((unused))
+static uint8_t cell_distance_reach(const uint8_t table[CELL_DISTANCE_ROWS][HELIX_COLS], keypos_t key, bool is_axis_only)
+{
+  int const row_begin = is_master ? 0 : HELIX_ROWS;
+  uint8_t reach = 0u;
+
+  for ( int row = 0; row < HELIX_ROWS; row++ ) {
+    int const d_row = key.row - (row_begin + row);
+    int d_col;
+    if ( is_axis_only && (d_row != 0) ) {
+      if ( pgm_read_byte(&keypos2ledidx[row][key.col]) == 0u ) {
+        continue;
+      }
+      d_col = 0;
+    }
+    else {
+      int col_first = 0;
+      int col_last  = HELIX_COLS - 1;
+      while ( (col_first <= col_last) && (pgm_read_byte(&keypos2ledidx[row][col_first]) == 0u) ) {
+        col_first++;
+      }
+      while ( (col_first <= col_last) && (pgm_read_byte(&keypos2ledidx[row][col_last]) == 0u) ) {
+        col_last--;
+      }
+      if ( col_first > col_last ) {
+        continue;
+      }
+      d_col = MAX(abs(key.col - col_first), abs(key.col - col_last));
+    }
+    reach = MAX(reach, cell_distance(table, d_row, d_col));
+  }
+  return reach;
+}
+
+// insertion sort of the cell offsets by distance(), once at init
+__attribute__ ((unused))
+static void ring_index_init(void)
+{
+  // unrounded distance() numerator, so ties are ties at every factor
+  #define RING_KEY(d_row, d_col)  CELL_DISTANCE(1024L, d_row, d_col)
+
+  uint8_t num = 0;
+  for ( int d_row = 0; d_row < CELL_DISTANCE_ROWS; d_row++ ) {
+    for ( int d_col = 0; d_col < HELIX_COLS; d_col++ ) {
+      long const key = RING_KEY(d_row, d_col);
+      uint8_t idx = num++;
+      for ( ; idx > 0; idx-- ) {
+        uint8_t const prev = ring_index[idx - 1];
+        if ( RING_KEY(RING_ROW(prev), RING_COL(prev)) <= key ) {
+          break;
+        }
+        ring_index[idx] = prev;
+      }
+      ring_index[idx] = RING_CELL(d_row, d_col);
+    }
+  }
+}
+
+__attribute__ ((unused))
+static uint8_t ring_distance(const uint8_t table[CELL_DISTANCE_ROWS][HELIX_COLS], uint8_t ring)
+{
+  uint8_t const cell = ring_index[ring];
+  return cell_distance(table, RING_ROW(cell), RING_COL(cell));
+}
+
+// LEDs of the keys at one ring_index[] offset from source, on this half
+__attribute__ ((unused))
+static uint8_t ring_get_ledidx(keypos_t source, uint8_t ring, int ledidx[4])
+{
+  uint8_t const cell  = ring_index[ring];
+  int const d_row     = RING_ROW(cell);
+  int const d_col     = RING_COL(cell);
+  int const row_begin = is_master ? 0 : HELIX_ROWS;
+  uint8_t num = 0;
+
+  for ( int sign_row = -1; sign_row <= 1; sign_row += 2 ) {
+    int const row = source.row + sign_row * d_row;
+    if ( (row_begin <= row) && (row < row_begin + HELIX_ROWS) ) {
+      for ( int sign_col = -1; sign_col <= 1; sign_col += 2 ) {
+        int const col = source.col + sign_col * d_col;
+        if ( (0 <= col) && (col < HELIX_COLS) ) {
+          int led_idx = get_ledidx_from_keypos( (keypos_t){.col=col, .row=row} );
+          if (led_idx >= 0) {
+            ledidx[num++] = led_idx;
+          }
+        }
+        if (d_col == 0) {
+          break;
+        }
+      }
+    }
+    if (d_row == 0) {
+      break;
+    }
+  }
+
+  return num;
+}
+
 __attribute__ ((unused))
 static int distance_from_line(int x, int y, int m, int n)
 {
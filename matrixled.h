@@ -16,9 +16,30 @@
 #define ENABLE_MATLED_RIPPLE_PATTERN
 #define ENABLE_MATLED_CROSS_PATTERN
 #define ENABLE_MATLED_WAVE_PATTERN
+// key events only post the frame, it is sent from the next matled_refresh_task()
+#define MATLED_DEFERRED_DRAW
+// value of a static colour at the rgblight hue under SWITCH, DIMLY, RIPPLE and CROSS
+//#define MATLED_BASE_VAL     24
+// RIPPLE and CROSS sources in flight, a press beyond cuts the oldest one short
+#define MATLED_PRESSED_NUM  8
+// a press within MATLED_COALESCE_TIME ms and MATLED_COALESCE_CELLS keys of a
+// source in flight adds its weight to that source instead of queueing another,
+// 0 ms to queue every press
+#define MATLED_COALESCE_TIME    40
+#define MATLED_COALESCE_CELLS   1
+
+// since matled_init()
+struct MatledPressedCounts {
+  uint32_t posted;      // sources queued
+  uint32_t evicted;     // sources cut short by a newer one as the queue was full
+  uint32_t coalesced;   // presses added to a source in flight
+  uint8_t peak;         // most sources in flight at once
+};
 
 void matled_init(void);
 int matled_get_mode(void);
+uint32_t matled_get_idle_time(void);  // ms, total time the engine has been idle
+const struct MatledPressedCounts *matled_get_pressed_counts(void);
 void matled_refresh_task(void);
 bool matled_record_event(uint16_t keycode, keyrecord_t *record);
 
@@ -0,0 +1,182 @@
+#include "config.h"
+
+#include QMK_KEYBOARD_H
+#include "i2c.h"
+#include "oledtask.h"
+#include "profiler.h"
+#include "trace.h"
+// Glyphs for oled_flush(). Nothing here references matrix_render(),
+// so --gc-sections drops it together with the driver's copy of the font.
+#include "helixfont.h"
+
+#define OLED_CONTROL_COMMAND    0x00  // command stream follows
+#define OLED_CONTROL_DATA       0x40  // GDDRAM data stream follows
+
+// bus bytes around the glyphs of one slice: the window transfer, then address and control byte
+#define OLED_SLICE_OVERHEAD     (8 + 2)
+// bus bytes of iota_gfx_on(): address, control byte and DisplayOn
+#define OLED_DISPLAY_ON_BYTES   3
+
+#ifdef OLED_FLUSH_BUDGET
+# if OLED_FLUSH_BUDGET < OLED_DISPLAY_ON_BYTES + OLED_SLICE_OVERHEAD + FontWidth
+#   error OLED_FLUSH_BUDGET can not carry a single character
+# endif
+# define OLED_SLICE_CHARS       ((OLED_FLUSH_BUDGET - OLED_SLICE_OVERHEAD) / FontWidth)
+// the slice of the scan that wakes the display up
+# define OLED_WAKE_SLICE_CHARS  ((OLED_FLUSH_BUDGET - OLED_DISPLAY_ON_BYTES - OLED_SLICE_OVERHEAD) / FontWidth)
+#else
+# define OLED_SLICE_CHARS       MatrixCols  // whole spans
+# define OLED_WAKE_SLICE_CHARS  MatrixCols
+#endif
+
+#define MIN(a,b)            (((a) < (b)) ? (a) : (b))
+#define MAX(a,b)            (((a) > (b)) ? (a) : (b))
+
+// Changed columns of each character row (one SSD1306 page) of display,
+// [begin, end), clean when begin == end.
+static struct DirtySpan {
+  uint8_t begin;
+  uint8_t end;
+} dirty_span[MatrixRows];
+
+static struct {
+  uint16_t last_flush;
+  bool is_on;
+} oled_status;
+
+static void oled_mark_dirty(uint8_t row, uint8_t col_begin, uint8_t col_end);
+static bool oled_is_dirty(void);
+static void oled_flush(uint8_t slice_chars);
+static bool oled_send_window(uint8_t page, uint8_t col_begin, uint8_t col_end);
+static bool oled_send_glyphs(const uint8_t *chars, uint8_t num);
+
+void oled_init(void)
+{
+  // the panel content is unknown to us, send everything once
+  for ( uint8_t row = 0; row < MatrixRows; row++ ) {
+    oled_mark_dirty(row, 0, MatrixCols);
+  }
+  oled_status.is_on = true;
+  oled_status.last_flush = timer_read();
+}
+
+void oled_task(void)
+{
+  PROFILE_BEGIN(OLED_RENDER);
+  iota_gfx_task_user();
+  PROFILE_END(OLED_RENDER);
+
+  if (oled_is_dirty()) {
+    PROFILE_BEGIN(OLED_FLUSH);
+    uint8_t slice_chars = OLED_SLICE_CHARS;
+    if (!oled_status.is_on) {
+      iota_gfx_on();
+      oled_status.is_on = true;
+      slice_chars = OLED_WAKE_SLICE_CHARS;  // DisplayOn went out on the same budget
+    }
+    oled_flush(slice_chars);
+    oled_status.last_flush = timer_read();
+    PROFILE_END(OLED_FLUSH);
+  }
+  else if ( oled_status.is_on && (timer_elapsed(oled_status.last_flush) > OLED_SCREEN_OFF_INTERVAL) ) {
+    iota_gfx_off();
+    oled_status.is_on = false;
+  }
+}
+
+// copy source into display, remembering which characters changed
+void oled_update(const struct CharacterMatrix *source)
+{
+  for ( uint8_t row = 0; row < MatrixRows; row++ ) {
+    uint8_t *dest = display.display[row];
+    const uint8_t *src = source->display[row];
+    for ( uint8_t col = 0; col < MatrixCols; col++ ) {
+      if ( dest[col] != src[col] ) {
+        dest[col] = src[col];
+        oled_mark_dirty(row, col, col + 1);
+      }
+    }
+  }
+}
+
+__attribute__ ((unused))
+static void oled_mark_dirty(uint8_t row, uint8_t col_begin, uint8_t col_end)
+{
+  struct DirtySpan *span = &dirty_span[row];
+  if ( span->begin == span->end ) {
+    span->begin = col_begin;
+    span->end   = col_end;
+  }
+  else {
+    span->begin = MIN(span->begin, col_begin);
+    span->end   = MAX(span->end, col_end);
+  }
+}
+
+__attribute__ ((unused))
+static bool oled_is_dirty(void)
+{
+  for ( uint8_t row = 0; row < MatrixRows; row++ ) {
+    if ( dirty_span[row].begin != dirty_span[row].end ) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// One page window and one data burst per slice of a dirty row.
+// A sent slice moves span->begin on, so a sliced flush resumes from the
+// spans alone, and characters changed meanwhile just widen them again.
+// A slice that fails to go out stays dirty for the next scan.
+__attribute__ ((unused))
+static void oled_flush(uint8_t slice_chars)
+{
+  for ( uint8_t row = 0; row < MatrixRows; row++ ) {
+    struct DirtySpan *span = &dirty_span[row];
+    if ( span->begin == span->end ) {
+      continue;
+    }
+
+    uint8_t const slice_end = MIN(span->end, span->begin + slice_chars);
+    if ( oled_send_window(row, span->begin, slice_end)
+         && oled_send_glyphs(&display.display[row][span->begin], slice_end - span->begin) ) {
+      TRACE(OLED_FLUSH, (row << 8) | (slice_end - span->begin));
+      span->begin = slice_end;
+    }
+
+    #ifdef OLED_FLUSH_BUDGET
+      break;  // one slice per scan
+    #endif
+  }
+}
+
+__attribute__ ((unused))
+static bool oled_send_window(uint8_t page, uint8_t col_begin, uint8_t col_end)
+{
+  const uint8_t cmds[] = {
+    OLED_CONTROL_COMMAND,
+    PageAddr,   page, page,
+    ColumnAddr, col_begin * FontWidth, col_end * FontWidth - 1,
+  };
+  bool is_sent = !i2c_master_start((SSD1306_ADDRESS << 1) | I2C_WRITE);
+  for ( uint8_t idx = 0; is_sent && idx < sizeof(cmds); idx++ ) {
+    is_sent = !i2c_master_write(cmds[idx]);
+  }
+  i2c_master_stop();
+  return is_sent;
+}
+
+__attribute__ ((unused))
+static bool oled_send_glyphs(const uint8_t *chars, uint8_t num)
+{
+  bool is_sent = !i2c_master_start((SSD1306_ADDRESS << 1) | I2C_WRITE)
+                 && !i2c_master_write(OLED_CONTROL_DATA);
+  for ( uint8_t idx = 0; is_sent && idx < num; idx++ ) {
+    const unsigned char *glyph = &font[chars[idx] * FontWidth];
+    for ( uint8_t glyph_col = 0; is_sent && glyph_col < FontWidth; glyph_col++ ) {
+      is_sent = !i2c_master_write(pgm_read_byte(&glyph[glyph_col]));
+    }
+  }
+  i2c_master_stop();
+  return is_sent;
+}
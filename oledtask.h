@@ -0,0 +1,20 @@
+#ifndef OLEDTASK_H
+#define OLEDTASK_H
+
+#if !defined(SSD1306OLED)
+# error please enable SSD1306OLED, check ./rules.mk: OLED_ENABLE = yes
+#endif
+
+#include "ssd1306.h"
+
+// config
+#define OLED_SCREEN_OFF_INTERVAL    60000 // ms, same as ScreenOffInterval of ssd1306.c
+// Bus bytes per oled_task(), a scan sends at most this and at most one page,
+// the rest goes out on the following scans. Undefine to flush everything at once.
+#define OLED_FLUSH_BUDGET           64    // bytes, about 1.5ms at 400kHz
+
+void oled_init(void);       // call after iota_gfx_init()
+void oled_task(void);       // instead of iota_gfx_task(), sends only the changed characters
+void oled_update(const struct CharacterMatrix *source);
+
+#endif //OLEDTASK_H
@@ -0,0 +1,55 @@
+#include "config.h"
+
+#ifdef MATRIX_SCAN_RUN_TIME
+
+#include QMK_KEYBOARD_H
+#include "profiler.h"
+
+struct ProfileStat profile_stats[PP_NUM];
+
+void profile_record(enum profile_probe probe, uint16_t begin_ticks)
+{
+  uint16_t const ticks = profile_ticks() - begin_ticks;
+  struct ProfileStat *stat = &profile_stats[probe];
+
+  if ( stat->count == 0u || ticks < stat->min ) {
+    stat->min = ticks;
+  }
+  if ( ticks > stat->max ) {
+    stat->max = ticks;
+  }
+  stat->count++;
+  stat->sum += ticks;
+
+  uint8_t bucket = 0;
+  for ( uint16_t rest = ticks >> (PROFILE_HIST_SHIFT + 1); rest != 0u && bucket < PROFILE_HIST_NUM - 1; rest >>= 1 ) {
+    bucket++;
+  }
+  if ( stat->hist[bucket] == UINT16_MAX ) {
+    // keep the shape, forget the oldest half
+    for ( uint8_t idx = 0; idx < PROFILE_HIST_NUM; idx++ ) {
+      stat->hist[idx] >>= 1;
+    }
+  }
+  stat->hist[bucket]++;
+}
+
+void profile_clear(void)
+{
+  memset(profile_stats, 0, sizeof(profile_stats));
+}
+
+// Utility for define string data
+#define DEFINE_STR_ITEM( name )  STR_##name[] PROGMEM = #name
+#define INITIALIZE_PP_ITEM_TO_STR( name )  [PP_(name)] = STR_##name
+
+const char *profile_name_P(enum profile_probe probe)
+{
+  static const char
+    APPLY_PROFILE_PROBES( DEFINE_STR_ITEM ),
+    * const probe_names_lut[PP_NUM] = { APPLY_PROFILE_PROBES( INITIALIZE_PP_ITEM_TO_STR ) };
+
+  return (probe_names_lut[probe]);
+}
+
+#endif // MATRIX_SCAN_RUN_TIME
@@ -0,0 +1,79 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdint.h>
+
+// Hot path probes, compiled in with MATRIX_SCAN_RUN_TIME (see ./config.h).
+// Without it PROFILE_BEGIN()/PROFILE_END() are empty and nothing is linked.
+//   PROFILE_BEGIN(MATLED_DRAW);
+//   ...
+//   PROFILE_END(MATLED_DRAW);
+#define APPLY_PROFILE_PROBES( func ) \
+    func(MATLED_REFRESH), \
+    func(MATLED_DRAW),    \
+    func(RGBLIGHT_SET),   \
+    func(OLED_RENDER),    \
+    func(OLED_FLUSH),     \
+    func(PROCESS_RECORD)
+
+// Index of probe
+// e.g.: profile_stats[PP_(<NAME>)]
+#define PP_( name )   PP_##name
+enum profile_probe {
+  APPLY_PROFILE_PROBES( PP_ ),
+  PP_NUM
+};
+
+#ifdef MATRIX_SCAN_RUN_TIME
+
+// One tick is one count of timer0, which QMK runs at F_CPU/64 up to 250 per ms.
+#define PROFILE_TICK_US     4
+// bucket 0: ticks < 2^(PROFILE_HIST_SHIFT+1), bucket n: 2^(n+PROFILE_HIST_SHIFT) <= ticks,
+// up to 8ms in the last one, which takes the rest
+#define PROFILE_HIST_NUM    10
+#define PROFILE_HIST_SHIFT  2
+
+struct ProfileStat {
+  uint32_t count;
+  uint32_t sum;       // ticks
+  uint16_t min;
+  uint16_t max;
+  uint16_t hist[PROFILE_HIST_NUM];
+};
+extern struct ProfileStat profile_stats[PP_NUM];
+
+#ifdef __AVR__
+# include <avr/io.h>
+# if F_CPU != 16000000
+#   error PROFILE_TICK_US assumes a 16MHz F_CPU
+# endif
+#endif
+uint16_t timer_read(void);
+
+static inline uint16_t profile_ticks(void)
+{
+  #ifdef __AVR__
+    uint16_t ms;
+    uint8_t tcnt;
+    do {
+      ms   = timer_read();
+      tcnt = TCNT0;
+    } while (ms != timer_read());   // timer0 overflowed in between
+    return ms * 250u + tcnt;
+  #else
+    return timer_read() * 250u;
+  #endif
+}
+
+void profile_record(enum profile_probe probe, uint16_t begin_ticks);
+void profile_clear(void);
+const char *profile_name_P(enum profile_probe probe);
+
+# define PROFILE_BEGIN( name )  uint16_t const profile_begin_##name = profile_ticks()
+# define PROFILE_END( name )    profile_record(PP_(name), profile_begin_##name)
+#else
+# define PROFILE_BEGIN( name )
+# define PROFILE_END( name )
+#endif
+
+#endif //PROFILER_H
@@ -125,3 +125,13 @@ endif
 ifeq ($(strip $(LED_ANIMATIONS)) $(strip $(RGBLIGHT_ENABLE)), no yes)
     SRC += matrixled.c
 endif
+
+ifeq ($(strip $(OLED_ENABLE)), yes)
+    SRC += oledtask.c
+endif
+
+SRC += eecache.c
+# empty unless MATRIX_SCAN_RUN_TIME is defined in ./config.h
+SRC += profiler.c
+# empty unless TRACE_ENABLE is defined in ./config.h
+SRC += trace.c
@@ -0,0 +1,71 @@
+#include "config.h"
+
+#ifdef TRACE_ENABLE
+
+#include QMK_KEYBOARD_H
+#include "print.h"
+#include "trace.h"
+
+static struct TraceRecord {
+  uint8_t type;
+  uint16_t time;
+  uint16_t payload;
+} __attribute__ ((packed)) trace_buffer[TRACE_BUFFER_NUM];
+
+// begin: oldest record, num: records in the ring,
+// dropped: records lost since the ring was last full
+static struct {
+  uint8_t begin;
+  uint8_t num;
+  uint16_t dropped;
+} trace_status;
+
+static void trace_push(uint8_t type, uint16_t time, uint16_t payload)
+{
+  struct TraceRecord *record = &trace_buffer[(trace_status.begin + trace_status.num) % TRACE_BUFFER_NUM];
+  record->type    = type;
+  record->time    = time;
+  record->payload = payload;
+  trace_status.num++;
+}
+
+void trace_record(enum trace_event type, uint16_t payload)
+{
+  uint16_t const time = timer_read();
+
+  if ( trace_status.dropped > 0u ) {
+    if ( trace_status.num >= TRACE_BUFFER_NUM ) {
+      trace_status.dropped += (trace_status.dropped < UINT16_MAX);
+      return;
+    }
+    trace_push(TE_(DROPPED), time, trace_status.dropped);
+    trace_status.dropped = 0u;
+  }
+  // the last slot is kept for the DROPPED record
+  if ( trace_status.num >= TRACE_BUFFER_NUM - 1 ) {
+    trace_status.dropped = 1u;
+    return;
+  }
+  trace_push(type, time, payload);
+}
+
+// one console line of up to TRACE_DRAIN_BATCH records
+void trace_drain(void)
+{
+  if ( trace_status.num == 0u ) {
+    return;
+  }
+
+  print(TRACE_LINE_PREFIX);
+  for ( uint8_t idx = 0; idx < TRACE_DRAIN_BATCH && trace_status.num > 0u; idx++ ) {
+    const struct TraceRecord *record = &trace_buffer[trace_status.begin];
+    print_hex8(record->type);
+    print_hex16(record->time);
+    print_hex16(record->payload);
+    trace_status.begin = (trace_status.begin + 1) % TRACE_BUFFER_NUM;
+    trace_status.num--;
+  }
+  print("\n");
+}
+
+#endif // TRACE_ENABLE
@@ -0,0 +1,56 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+// Event trace, compiled in with TRACE_ENABLE (see ./config.h).
+// Hooks record a 5 byte {type, ms timestamp, payload} into a RAM ring,
+// trace_drain() sends a few of them per scan to the QMK console, and
+// bench/trace_decode turns a hid_listen capture into a timeline.
+//   TRACE(KEY_DOWN, (row << 8) | col);
+#define APPLY_TRACE_EVENTS( func ) \
+    func(DROPPED),      /* payload: records lost while the ring was full */   \
+    func(KEY_DOWN),     /* payload: row << 8 | col */                          \
+    func(KEY_UP),       /* payload: row << 8 | col */                          \
+    func(LAYER),        /* payload: low 16 bit of layer | default layer */     \
+    func(EEPROM),       /* payload: enum trace_eeprom */                       \
+    func(LED_REFRESH),  /* payload: mode << 8 | still animating */             \
+    func(LED_FRAME),    /* payload: mode, sent by rgblight_set() */            \
+    func(OLED_RENDER),  /* payload: 0 */                                       \
+    func(OLED_FLUSH)    /* payload: page << 8 | characters sent */
+
+// Index of event type
+// e.g.: TE_(<NAME>)
+#define TE_( name )   TE_##name
+enum trace_event {
+  APPLY_TRACE_EVENTS( TE_ ),
+  TE_NUM
+};
+
+enum trace_eeprom {
+  TRACE_EEPROM_DEFAULT_LAYER,
+  TRACE_EEPROM_RGBLIGHT,
+};
+
+// console line: TRACE_LINE_PREFIX, then 10 hex digits per record
+#define TRACE_LINE_PREFIX   "trace:"
+
+#ifdef TRACE_ENABLE
+
+#if !defined(CONSOLE_ENABLE)
+# error please enable CONSOLE_ENABLE for TRACE_ENABLE, check ./rules.mk
+#endif
+
+// config
+#define TRACE_BUFFER_NUM    32  // records, 5 bytes of RAM each
+#define TRACE_DRAIN_BATCH   4   // records per trace_drain()
+
+void trace_record(enum trace_event type, uint16_t payload);
+void trace_drain(void);
+
+# define TRACE( name, payload )   trace_record(TE_(name), (payload))
+#else
+# define TRACE( name, payload )
+#endif
+
+#endif //TRACE_H